@@ -0,0 +1,263 @@
+/*
+ * CPU topology discovery and thread pinning for the parallel miner
+ * Plain sysfs text parsing - no libnuma or hwloc required
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu_topology.h"
+
+#ifndef CPU_TOPOLOGY_SYSFS
+#define CPU_TOPOLOGY_SYSFS "/sys/devices/system"
+#endif
+
+#define CPU_CAPACITY_MAX 1024
+
+#ifdef __linux__
+
+// Read a small sysfs file into buf; returns 0 if missing
+static int read_sysfs(const char* path, char* buf, size_t size) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) {
+        return 0;
+    }
+    size_t len = fread(buf, 1, size - 1, fp);
+    fclose(fp);
+    buf[len] = '\0';
+    return len > 0;
+}
+
+static int read_sysfs_int(const char* path, int fallback) {
+    char buf[32];
+    return read_sysfs(path, buf, sizeof(buf)) ? atoi(buf) : fallback;
+}
+
+// Parse a cpulist like "0-3,8,10-11" into a membership table of size max_cpu
+static int parse_cpulist(const char* list, unsigned char* member, int max_cpu) {
+    const char* p = list;
+    int count = 0;
+
+    while (*p) {
+        char* end;
+        long first = strtol(p, &end, 10);
+        if (end == p) {
+            break;
+        }
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            p = end;
+        }
+        for (long cpu = first; cpu <= last && cpu < max_cpu; cpu++) {
+            if (cpu >= 0 && !member[cpu]) {
+                member[cpu] = 1;
+                count++;
+            }
+        }
+        if (*p == ',') {
+            p++;
+        } else {
+            break;
+        }
+    }
+    return count;
+}
+
+// Index of cpu within its core's sibling list (0 for the first hardware thread)
+static int smt_rank(int cpu, const char* siblings) {
+    const char* p = siblings;
+    int rank = 0;
+
+    while (*p) {
+        char* end;
+        long first = strtol(p, &end, 10);
+        if (end == p) {
+            break;
+        }
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            p = end;
+        }
+        if (cpu >= first && cpu <= last) {
+            return rank + (int)(cpu - first);
+        }
+        rank += (int)(last - first + 1);
+        if (*p == ',') {
+            p++;
+        } else {
+            break;
+        }
+    }
+    return 0;
+}
+
+// Physical cores first, then SMT siblings; fastest cores first within each round
+static int placement_order(const void* a, const void* b) {
+    const cpu_info_t* x = a;
+    const cpu_info_t* y = b;
+
+    if (x->smt_rank != y->smt_rank) return x->smt_rank - y->smt_rank;
+    if (x->capacity != y->capacity) return y->capacity - x->capacity;
+    if (x->package_id != y->package_id) return x->package_id - y->package_id;
+    if (x->core_id != y->core_id) return x->core_id - y->core_id;
+    return x->cpu - y->cpu;
+}
+
+int cpu_topology_load(cpu_topology_t* topo) {
+    char path[256];
+    char buf[4096];
+    int max_cpu = CPU_SETSIZE;
+    memset(topo, 0, sizeof(*topo));
+
+    if (!read_sysfs(CPU_TOPOLOGY_SYSFS "/cpu/online", buf, sizeof(buf))) {
+        return 0;
+    }
+
+    unsigned char* online = calloc(max_cpu, 1);
+    unsigned char* atom = calloc(max_cpu, 1);
+    int* node_of = malloc(max_cpu * sizeof(int));
+    topo->cpus = malloc(max_cpu * sizeof(cpu_info_t));
+    if (!online || !atom || !node_of || !topo->cpus) {
+        free(online);
+        free(atom);
+        free(node_of);
+        cpu_topology_free(topo);
+        return 0;
+    }
+    parse_cpulist(buf, online, max_cpu);
+
+    // Intel hybrid parts list their E-cores here
+    if (read_sysfs("/sys/devices/cpu_atom/cpus", buf, sizeof(buf))) {
+        parse_cpulist(buf, atom, max_cpu);
+    }
+
+    // NUMA node of every CPU (node numbers may be sparse)
+    for (int cpu = 0; cpu < max_cpu; cpu++) {
+        node_of[cpu] = -1;
+    }
+    unsigned char* nodes = calloc(max_cpu, 1);
+    unsigned char* member = calloc(max_cpu, 1);
+    if (nodes && member && read_sysfs(CPU_TOPOLOGY_SYSFS "/node/online", buf, sizeof(buf))) {
+        parse_cpulist(buf, nodes, max_cpu);
+        for (int node = 0; node < max_cpu; node++) {
+            snprintf(path, sizeof(path), CPU_TOPOLOGY_SYSFS "/node/node%d/cpulist", node);
+            if (!nodes[node] || !read_sysfs(path, buf, sizeof(buf))) {
+                continue;
+            }
+            memset(member, 0, max_cpu);
+            if (parse_cpulist(buf, member, max_cpu) > 0) {
+                topo->nodes++;
+            }
+            for (int cpu = 0; cpu < max_cpu; cpu++) {
+                if (member[cpu]) {
+                    node_of[cpu] = node;
+                }
+            }
+        }
+    }
+    free(nodes);
+    free(member);
+
+    // Respect taskset/cgroup restrictions on this process
+    cpu_set_t allowed;
+    int have_mask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+    int min_capacity = CPU_CAPACITY_MAX;
+    for (int cpu = 0; cpu < max_cpu; cpu++) {
+        if (!online[cpu] || (have_mask && !CPU_ISSET(cpu, &allowed))) {
+            continue;
+        }
+
+        cpu_info_t* info = &topo->cpus[topo->count++];
+        info->cpu = cpu;
+        info->node = node_of[cpu];
+
+        snprintf(path, sizeof(path), CPU_TOPOLOGY_SYSFS "/cpu/cpu%d/topology/core_id", cpu);
+        info->core_id = read_sysfs_int(path, cpu);
+        snprintf(path, sizeof(path), CPU_TOPOLOGY_SYSFS "/cpu/cpu%d/topology/physical_package_id", cpu);
+        info->package_id = read_sysfs_int(path, 0);
+
+        snprintf(path, sizeof(path), CPU_TOPOLOGY_SYSFS "/cpu/cpu%d/topology/thread_siblings_list", cpu);
+        info->smt_rank = read_sysfs(path, buf, sizeof(buf)) ? smt_rank(cpu, buf) : 0;
+
+        // cpu_capacity is exported on asymmetric systems; fall back to the E-core list
+        snprintf(path, sizeof(path), CPU_TOPOLOGY_SYSFS "/cpu/cpu%d/cpu_capacity", cpu);
+        info->capacity = read_sysfs_int(path, atom[cpu] ? CPU_CAPACITY_MAX / 2 : CPU_CAPACITY_MAX);
+        if (info->capacity < min_capacity) {
+            min_capacity = info->capacity;
+        }
+    }
+
+    free(online);
+    free(atom);
+    free(node_of);
+
+    if (topo->count == 0) {
+        cpu_topology_free(topo);
+        return 0;
+    }
+
+    qsort(topo->cpus, topo->count, sizeof(cpu_info_t), placement_order);
+
+    int max_package = -1;
+    for (int i = 0; i < topo->count; i++) {
+        const cpu_info_t* info = &topo->cpus[i];
+        if (info->smt_rank == 0) {
+            topo->physical_cores++;
+        }
+        if (info->package_id > max_package) {
+            max_package = info->package_id;
+        }
+        if (info->capacity != min_capacity) {
+            topo->hybrid = 1;
+        }
+    }
+    topo->packages = max_package + 1;
+    if (topo->nodes == 0) {
+        topo->nodes = 1;
+    }
+    return 1;
+}
+
+int cpu_topology_pin_self(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+#else
+
+int cpu_topology_load(cpu_topology_t* topo) {
+    memset(topo, 0, sizeof(*topo));
+    return 0;
+}
+
+int cpu_topology_pin_self(int cpu) {
+    (void)cpu;
+    return 0;
+}
+
+#endif
+
+void cpu_topology_free(cpu_topology_t* topo) {
+    free(topo->cpus);
+    topo->cpus = NULL;
+    topo->count = 0;
+}
+
+// CPU for worker `index` (wraps when there are more workers than CPUs)
+const cpu_info_t* cpu_topology_place(const cpu_topology_t* topo, int index) {
+    return &topo->cpus[index % topo->count];
+}
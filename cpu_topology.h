@@ -0,0 +1,41 @@
+/*
+ * CPU topology discovery and thread pinning for the parallel miner
+ * Reads /sys/devices/system/cpu and /sys/devices/system/node on Linux;
+ * elsewhere loading fails and the miner stays unpinned.
+ */
+
+#ifndef CPU_TOPOLOGY_H
+#define CPU_TOPOLOGY_H
+
+// One online logical CPU
+typedef struct {
+    int cpu;                // Logical CPU number
+    int core_id;            // Physical core within its package
+    int package_id;         // Socket
+    int node;               // NUMA node, -1 if unknown
+    int smt_rank;           // 0 for the first hardware thread of a core, 1 for its sibling, ...
+    int capacity;           // Relative core capacity (1024 = fastest), lower on E-cores
+} cpu_info_t;
+
+// Online CPUs this process may run on, in placement order: every physical
+// core (fastest cores first, then by package) before any SMT sibling
+typedef struct {
+    cpu_info_t* cpus;
+    int count;
+    int physical_cores;
+    int packages;
+    int nodes;
+    int hybrid;             // Cores of different capacity were found
+} cpu_topology_t;
+
+// Returns 0 when the topology cannot be read (non-Linux, no sysfs)
+int cpu_topology_load(cpu_topology_t* topo);
+void cpu_topology_free(cpu_topology_t* topo);
+
+// CPU for worker `index` (wraps when there are more workers than CPUs)
+const cpu_info_t* cpu_topology_place(const cpu_topology_t* topo, int index);
+
+// Pin the calling thread to one logical CPU; returns 0 on failure
+int cpu_topology_pin_self(int cpu);
+
+#endif
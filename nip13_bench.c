@@ -0,0 +1,511 @@
+/*
+ * Microbenchmarks for the NIP-13 miners
+ * Times the SHA256 backends, the leading-zero check, event serialization,
+ * nonce mutation and full attempts in isolation, prints the results as
+ * JSON and compares them against a stored baseline.
+ */
+
+// clock_gettime under -std=c11
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_CYCLE_COUNTER 1
+#else
+#define HAVE_CYCLE_COUNTER 0
+#endif
+
+#include "sha256.h"
+#include "sha256_simd.h"
+#include "nostr_event.h"
+#include "nip13_engine.h"
+
+#define BENCH_MAX_RESULTS 32
+#define BENCH_CALIBRATE_NS 10000000ULL
+
+// Target committed in the benchmark event's nonce tag
+#define BENCH_TARGET 20
+
+// Event used by the serializer and attempt cases: a few tags, escapes and
+// enough content that the nonce lands a couple of blocks in
+static const char* bench_event =
+    "{\"id\":\"\",\"pubkey\":\"32e1827635450ebb3c5a7d12c1f8e7b2b514439ac10a67eef3d9fd9c5c68e245\","
+    "\"created_at\":1673347337,\"kind\":1,\"tags\":[[\"e\",\"5c83da77af1dec6d7289834998ad7aafbd9e2191396d75ec3cc27f5a77226f36\","
+    "\"wss://nostr.example.com\"],[\"p\",\"f7234bd4c1394dda46d09f35bd384dd30cc552ad5541990f98844fb06676e9ca\"],"
+    "[\"t\",\"nostr\"]],\"content\":\"Benchmarking NIP-13 \\\"proof of work\\\"\\nwith a second line\",\"sig\":\"\"}";
+
+// One case: runs `iterations` iterations and returns the operations done
+typedef uint64_t (*bench_fn)(void* ctx, uint64_t iterations);
+
+typedef struct {
+    char name[48];
+    const char* unit;               // What one operation is
+    uint64_t ops;                   // Operations in the fastest repetition
+    double ns_per_op;
+    double cycles_per_op;           // TSC reference cycles, -1 without a counter
+} bench_result_t;
+
+typedef struct {
+    uint64_t time_ns;               // Target time per repetition
+    int reps;
+    const char* filter;             // Only cases whose name contains this
+    bench_result_t results[BENCH_MAX_RESULTS];
+    int count;
+} bench_t;
+
+// Defeats dead-code elimination of the measured work
+static volatile uint64_t bench_sink;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t read_cycles(void) {
+#if HAVE_CYCLE_COUNTER
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// Calibrate, then keep the fastest of reps repetitions: the minimum is the
+// run least disturbed by the scheduler and frequency ramps
+static void bench_run(bench_t* bench, const char* name, const char* unit, bench_fn fn, void* ctx) {
+    if (bench->filter && !strstr(name, bench->filter)) {
+        return;
+    }
+    if (bench->count == BENCH_MAX_RESULTS) {
+        fprintf(stderr, "⚠️  Too many cases, skipping %s\n", name);
+        return;
+    }
+
+    uint64_t iterations = 1;
+    uint64_t elapsed;
+    while (1) {
+        uint64_t start = now_ns();
+        fn(ctx, iterations);
+        elapsed = now_ns() - start;
+        if (elapsed >= BENCH_CALIBRATE_NS || iterations >= (1ULL << 40)) {
+            break;
+        }
+        iterations *= 2;
+    }
+    iterations = (uint64_t)((double)iterations * bench->time_ns / (elapsed ? elapsed : 1));
+    if (iterations < 1) {
+        iterations = 1;
+    }
+
+    bench_result_t* result = &bench->results[bench->count++];
+    snprintf(result->name, sizeof(result->name), "%s", name);
+    result->unit = unit;
+    result->ns_per_op = -1;
+    for (int rep = 0; rep < bench->reps; rep++) {
+        uint64_t start = now_ns();
+        uint64_t cycles = read_cycles();
+        uint64_t ops = fn(ctx, iterations);
+        cycles = read_cycles() - cycles;
+        double ns = (double)(now_ns() - start) / ops;
+        if (result->ns_per_op < 0 || ns < result->ns_per_op) {
+            result->ops = ops;
+            result->ns_per_op = ns;
+            result->cycles_per_op = HAVE_CYCLE_COUNTER ? (double)cycles / ops : -1;
+        }
+    }
+
+    fprintf(stderr, "⏱️  %-28s %10.2f ns/%s", name, result->ns_per_op, unit);
+    if (result->cycles_per_op >= 0) {
+        fprintf(stderr, " %10.1f cycles/%s", result->cycles_per_op, unit);
+    }
+    fprintf(stderr, "\n");
+}
+
+// Single-block compression on one backend
+typedef struct {
+    sha256_block_fn fn;
+    uint32_t state[8];
+    uint8_t block[SHA256_BLOCK_SIZE];
+} transform_ctx_t;
+
+static uint64_t bench_transform(void* arg, uint64_t iterations) {
+    transform_ctx_t* ctx = arg;
+    for (uint64_t i = 0; i < iterations; i++) {
+        ctx->fn(ctx->state, ctx->block);
+    }
+    bench_sink += ctx->state[0];
+    return iterations;
+}
+
+// One block per lane on a multi-buffer kernel
+typedef struct {
+    sha256_multi_fn fn;
+    int lanes;
+    uint32_t midstate[8];
+    uint32_t words[16 * SHA256_MAX_LANES];
+    uint32_t h0[SHA256_MAX_LANES];
+    uint32_t h1[SHA256_MAX_LANES];
+} multi_ctx_t;
+
+static uint64_t bench_multi(void* arg, uint64_t iterations) {
+    multi_ctx_t* ctx = arg;
+    uint32_t hits = 0;
+    for (uint64_t i = 0; i < iterations; i++) {
+        ctx->words[0] += ctx->h0[0];
+        hits |= ctx->fn(ctx->midstate, NULL, ctx->words, 1, 64, ctx->h0, ctx->h1);
+    }
+    bench_sink += hits + ctx->h0[0];
+    return iterations * ctx->lanes;
+}
+
+// Leading-zero checks over a table of hash words
+typedef struct {
+    uint32_t words[1024];
+    uint8_t digests[64][SHA256_DIGEST_SIZE];
+} zeros_ctx_t;
+
+static uint64_t bench_state_zeros(void* arg, uint64_t iterations) {
+    zeros_ctx_t* ctx = arg;
+    uint64_t total = 0;
+    for (uint64_t i = 0; i < iterations; i++) {
+        total += nip13_state_zeros(ctx->words[i & 1023], ctx->words[(i + 1) & 1023]);
+    }
+    bench_sink += total;
+    return iterations;
+}
+
+static uint64_t bench_digest_zeros(void* arg, uint64_t iterations) {
+    zeros_ctx_t* ctx = arg;
+    uint64_t total = 0;
+    for (uint64_t i = 0; i < iterations; i++) {
+        total += count_leading_zeros(ctx->digests[i & 63]);
+    }
+    bench_sink += total;
+    return iterations;
+}
+
+// Event JSON helpers on bench_event
+static uint64_t bench_parse(void* arg, uint64_t iterations) {
+    (void)arg;
+    for (uint64_t i = 0; i < iterations; i++) {
+        nostr_event_t ev;
+        bench_sink += nostr_event_parse(bench_event, &ev);
+        nostr_event_free(&ev);
+    }
+    return iterations;
+}
+
+static uint64_t bench_canonical(void* arg, uint64_t iterations) {
+    (void)arg;
+    for (uint64_t i = 0; i < iterations; i++) {
+        char* canonical = build_canonical_event(bench_event, NULL);
+        bench_sink += canonical[1];
+        free(canonical);
+    }
+    return iterations;
+}
+
+static uint64_t bench_template(void* arg, uint64_t iterations) {
+    (void)arg;
+    for (uint64_t i = 0; i < iterations; i++) {
+        nip13_template_t tmpl;
+        bench_sink += nip13_template_init(&tmpl, bench_event, 1000000000ULL, BENCH_TARGET);
+        nip13_template_free(&tmpl);
+    }
+    return iterations;
+}
+
+// Nonce mutation: in-place ASCII increment and the final event rewrite
+typedef struct {
+    const nip13_template_t* tmpl;
+    nip13_cursor_t cursor;
+} nonce_ctx_t;
+
+static uint64_t bench_nonce_increment(void* arg, uint64_t iterations) {
+    nonce_ctx_t* ctx = arg;
+    nip13_cursor_seek(&ctx->cursor, 0);
+    for (uint64_t i = 0; i < iterations; i++) {
+        nip13_cursor_next(&ctx->cursor);
+    }
+    bench_sink += ctx->cursor.digits[0];
+    return iterations;
+}
+
+static uint64_t bench_nonce_event(void* arg, uint64_t iterations) {
+    nonce_ctx_t* ctx = arg;
+    for (uint64_t i = 0; i < iterations; i++) {
+        char* json = nip13_template_event_json(ctx->tmpl, bench_event, i);
+        bench_sink += json[0];
+        free(json);
+    }
+    return iterations;
+}
+
+// Full attempts: hash-and-test through the batch the miners use
+static uint64_t bench_attempts(void* arg, uint64_t iterations) {
+    nip13_batch_t* batch = arg;
+    uint64_t attempts = 0;
+    uint32_t hits = 0;
+    nip13_batch_seek(batch, 0);
+    for (uint64_t i = 0; i < iterations; i++) {
+        uint32_t mask;
+        attempts += nip13_batch_scan(batch, 64, ~0ULL, &mask);
+        hits |= mask;
+        nip13_batch_next(batch);
+    }
+    bench_sink += hits;
+    return attempts;
+}
+
+static void write_results(FILE* out, const bench_t* bench) {
+    sha256_multi_fn kernel;
+    int lanes = sha256_multi_select(&kernel);
+
+    fprintf(out, "{\"backend\":\"%s\",\"kernel\":\"%s\",\"lanes\":%d,\"cycle_counter\":\"%s\",\"results\":[",
+            sha256_backend_name(), sha256_multi_name(lanes), lanes, HAVE_CYCLE_COUNTER ? "tsc" : "none");
+    for (int i = 0; i < bench->count; i++) {
+        const bench_result_t* r = &bench->results[i];
+        fprintf(out, "%s\n{\"name\":\"%s\",\"unit\":\"%s\",\"ops\":%llu,\"ns_per_op\":%.4f,\"ops_per_sec\":%.1f,",
+                i ? "," : "", r->name, r->unit, (unsigned long long)r->ops, r->ns_per_op, 1e9 / r->ns_per_op);
+        if (r->cycles_per_op >= 0) {
+            fprintf(out, "\"cycles_per_op\":%.2f}", r->cycles_per_op);
+        } else {
+            fprintf(out, "\"cycles_per_op\":null}");
+        }
+    }
+    fprintf(out, "\n]}\n");
+}
+
+// Read a whole file (caller frees, NULL if unreadable)
+static char* read_file(const char* path) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) {
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char* text = size >= 0 ? malloc(size + 1) : NULL;
+    if (text) {
+        text[fread(text, 1, size, fp)] = '\0';
+    }
+    fclose(fp);
+    return text;
+}
+
+// Compare against a baseline written by an earlier run; returns the number
+// of cases more than threshold percent slower, -1 if the baseline is unusable
+static int compare_baseline(const bench_t* bench, const char* path, double threshold) {
+    char* json = read_file(path);
+    const char* results = json ? json_object_member(json, "results", NULL) : NULL;
+    int count = results ? json_array_elements(results, NULL, NULL, 0) : -1;
+    if (count < 0) {
+        free(json);
+        return -1;
+    }
+
+    size_t* starts = malloc((count + 1) * sizeof(size_t));
+    size_t* ends = malloc((count + 1) * sizeof(size_t));
+    json_array_elements(results, starts, ends, count);
+
+    fprintf(stderr, "\n📊 Against baseline %s (threshold %.1f%%):\n", path, threshold);
+    int regressions = 0;
+    for (int i = 0; i < bench->count; i++) {
+        const bench_result_t* r = &bench->results[i];
+        double base_ns = -1;
+        for (int j = 0; j < count && base_ns < 0; j++) {
+            char* name = extract_json_field(results + starts[j], "name");
+            char* ns = extract_json_field(results + starts[j], "ns_per_op");
+            if (name && ns && strcmp(name, r->name) == 0) {
+                base_ns = strtod(ns, NULL);
+            }
+            free(name);
+            free(ns);
+        }
+        if (base_ns <= 0) {
+            fprintf(stderr, "   %-28s new case, no baseline\n", r->name);
+            continue;
+        }
+
+        // Positive change means slower than the baseline
+        double change = (r->ns_per_op - base_ns) / base_ns * 100.0;
+        int regressed = change > threshold;
+        regressions += regressed;
+        fprintf(stderr, "%s %-28s %10.2f -> %10.2f ns/%s (%+.1f%%)\n", regressed ? "❌" : "✅",
+                r->name, base_ns, r->ns_per_op, r->unit, change);
+    }
+
+    free(starts);
+    free(ends);
+    free(json);
+    return regressions;
+}
+
+static void usage(const char* prog) {
+    printf("Usage: %s [--time-ms MS] [--reps N] [--filter TEXT] [--output FILE]\n", prog);
+    printf("          [--baseline FILE] [--threshold PCT]\n");
+    printf("  --time-ms    Time per repetition of each case (default: 200)\n");
+    printf("  --reps       Repetitions per case; the fastest is kept (default: 5)\n");
+    printf("  --filter     Only run cases whose name contains TEXT\n");
+    printf("  --output     Write the JSON results to FILE instead of stdout\n");
+    printf("  --baseline   Compare against results saved by an earlier run\n");
+    printf("  --threshold  Percent slowdown against the baseline that fails (default: 10)\n\n");
+    printf("Exit status is 1 when any case regressed past the threshold.\n");
+}
+
+int main(int argc, char* argv[]) {
+    bench_t bench = { .time_ns = 200000000ULL, .reps = 5 };
+    const char* output = NULL;
+    const char* baseline = NULL;
+    double threshold = 10.0;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+            usage(argv[0]);
+            return 0;
+        }
+        if (!value) {
+            usage(argv[0]);
+            return 1;
+        }
+        if (strcmp(arg, "--time-ms") == 0) {
+            bench.time_ns = strtoull(value, NULL, 10) * 1000000ULL;
+        } else if (strcmp(arg, "--reps") == 0) {
+            bench.reps = atoi(value);
+        } else if (strcmp(arg, "--filter") == 0) {
+            bench.filter = value;
+        } else if (strcmp(arg, "--output") == 0) {
+            output = value;
+        } else if (strcmp(arg, "--baseline") == 0) {
+            baseline = value;
+        } else if (strcmp(arg, "--threshold") == 0) {
+            threshold = strtod(value, NULL);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+    if (bench.time_ns == 0 || bench.reps < 1 || threshold < 0) {
+        printf("❌ Error: Time, repetitions and threshold must be positive\n");
+        return 1;
+    }
+
+    fprintf(stderr, "🧮 SHA256 backend: %s, cycle counter: %s\n", sha256_backend_name(),
+            HAVE_CYCLE_COUNTER ? "TSC (reference cycles)" : "none");
+
+    // SHA256 compression, one block per hash, on every backend this CPU has
+    static const char* backends[] = { "scalar", "shani" };
+    transform_ctx_t transform;
+    memset(&transform, 0, sizeof(transform));
+    for (int i = 0; i < SHA256_BLOCK_SIZE; i++) {
+        transform.block[i] = (uint8_t)(i * 7 + 1);
+    }
+    for (size_t i = 0; i < sizeof(backends) / sizeof(backends[0]); i++) {
+        char name[48];
+        transform.fn = sha256_backend_lookup(backends[i]);
+        if (transform.fn) {
+            snprintf(name, sizeof(name), "sha256_transform/%s", backends[i]);
+            bench_run(&bench, name, "hash", bench_transform, &transform);
+        }
+    }
+
+    static const int multi_lanes[] = { 8, 16 };
+    multi_ctx_t multi;
+    memset(&multi, 0, sizeof(multi));
+    for (int i = 0; i < 16 * SHA256_MAX_LANES; i++) {
+        multi.words[i] = 0x9e3779b9u * (i + 1);
+    }
+    for (int i = 0; i < 8; i++) {
+        multi.midstate[i] = 0x6a09e667u + i;
+    }
+    for (size_t i = 0; i < sizeof(multi_lanes) / sizeof(multi_lanes[0]); i++) {
+        char name[48];
+        multi.lanes = multi_lanes[i];
+        if (sha256_multi_lookup(multi.lanes, &multi.fn) && multi.fn) {
+            snprintf(name, sizeof(name), "sha256_multi/%s", sha256_multi_name(multi.lanes));
+            bench_run(&bench, name, "hash", bench_multi, &multi);
+        }
+    }
+
+    // Difficulty checks
+    zeros_ctx_t* zeros = malloc(sizeof(zeros_ctx_t));
+    uint32_t seed = 12345;
+    for (int i = 0; i < 1024; i++) {
+        seed = seed * 1103515245u + 12345u;
+        zeros->words[i] = seed >> (seed & 15);
+    }
+    for (int i = 0; i < 64; i++) {
+        sha256_hash((const uint8_t*)&zeros->words[i], sizeof(uint32_t), zeros->digests[i]);
+        zeros->digests[i][0] = 0;
+    }
+    bench_run(&bench, "leading_zeros/state", "check", bench_state_zeros, zeros);
+    bench_run(&bench, "leading_zeros/digest", "check", bench_digest_zeros, zeros);
+    free(zeros);
+
+    // Serialization: once per event or job, not per attempt
+    bench_run(&bench, "event/parse", "event", bench_parse, NULL);
+    bench_run(&bench, "event/canonical", "event", bench_canonical, NULL);
+    bench_run(&bench, "event/template", "event", bench_template, NULL);
+
+    nip13_template_t tmpl;
+    if (!nip13_template_init(&tmpl, bench_event, 1000000000000ULL, BENCH_TARGET)) {
+        printf("❌ Error: Cannot build the benchmark template\n");
+        return 1;
+    }
+    nonce_ctx_t nonce = { .tmpl = &tmpl };
+    if (nip13_cursor_init(&nonce.cursor, &tmpl)) {
+        bench_run(&bench, "nonce/increment", "nonce", bench_nonce_increment, &nonce);
+        nip13_cursor_free(&nonce.cursor);
+    }
+    bench_run(&bench, "nonce/event_json", "event", bench_nonce_event, &nonce);
+
+    // Full attempts on every lane count: digit increment, transpose and hash-and-test
+    static const int attempt_lanes[] = { 1, 8, 16 };
+    for (size_t i = 0; i < sizeof(attempt_lanes) / sizeof(attempt_lanes[0]); i++) {
+        nip13_batch_t batch;
+        if (!nip13_batch_init(&batch, &tmpl, attempt_lanes[i])) {
+            continue;
+        }
+        char name[48];
+        snprintf(name, sizeof(name), "attempt/%s", attempt_lanes[i] == 1 ? sha256_backend_name() :
+                 sha256_multi_name(attempt_lanes[i]));
+        bench_run(&bench, name, "attempt", bench_attempts, &batch);
+        nip13_batch_free(&batch);
+    }
+    nip13_template_free(&tmpl);
+
+    FILE* out = output ? fopen(output, "w") : stdout;
+    if (!out) {
+        printf("❌ Error: Cannot write %s\n", output);
+        return 1;
+    }
+    write_results(out, &bench);
+    if (output) {
+        fclose(out);
+        fprintf(stderr, "💾 Saved to: %s\n", output);
+    }
+
+    if (!baseline) {
+        return 0;
+    }
+    int regressions = compare_baseline(&bench, baseline, threshold);
+    if (regressions < 0) {
+        fprintf(stderr, "⚠️  No usable baseline at %s; record one with `make bench-baseline`\n", baseline);
+        return 0;
+    }
+    if (regressions > 0) {
+        fprintf(stderr, "❌ %d case(s) regressed more than %.1f%%\n", regressions, threshold);
+        return 1;
+    }
+    fprintf(stderr, "✅ No regressions\n");
+    return 0;
+}
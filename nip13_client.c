@@ -0,0 +1,145 @@
+/*
+ * Client for the nip13_parallel mining daemon
+ * Sends one request per event line on stdin and prints the result lines
+ * as the daemon writes them back
+ */
+
+// The socket API under -std=c99
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include "nostr_event.h"
+
+// Write the whole buffer, retrying short writes
+static int write_all(int fd, const char* buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return 0;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        printf("Usage: %s <socket> <difficulty> [deadline_ms] < events.jsonl\n", argv[0]);
+        printf("  socket       - Path the daemon listens on (nip13_parallel --serve)\n");
+        printf("  difficulty   - Target difficulty in bits for every event\n");
+        printf("  deadline_ms  - Give up on an event after this long (default: 0, no deadline)\n\n");
+        printf("Example:\n");
+        printf("  %s /tmp/nip13.sock 20 5000 < events.jsonl > mined.jsonl\n", argv[0]);
+        return 1;
+    }
+
+    const char* socket_path = argv[1];
+    int difficulty = atoi(argv[2]);
+    long long deadline_ms = (argc > 3) ? atoll(argv[3]) : 0;
+
+    if (difficulty < 1 || difficulty > 32) {
+        printf("❌ Error: Difficulty must be between 1 and 32 bits\n");
+        return 1;
+    }
+    if (deadline_ms < 0) {
+        printf("❌ Error: Deadline must not be negative\n");
+        return 1;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        printf("❌ Error: Socket path too long: %s\n", socket_path);
+        return 1;
+    }
+    strcpy(addr.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        printf("❌ Error: Cannot connect to %s\n", socket_path);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    // Send every request up front; the daemon applies backpressure by
+    // reading more slowly, and results come back in completion order.
+    // Requests are written from a child so a full socket buffer in one
+    // direction never stalls the other.
+    pid_t sender = fork();
+    if (sender < 0) {
+        printf("❌ Error: Cannot fork request sender\n");
+        close(fd);
+        return 1;
+    }
+    if (sender == 0) {
+        unsigned long long sent = 0;
+        char* line;
+        while ((line = nostr_read_line(stdin)) != NULL) {
+            size_t len = strlen(line);
+            while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r' ||
+                               line[len - 1] == ' ' || line[len - 1] == '\t')) {
+                line[--len] = '\0';
+            }
+            if (len == 0) {
+                free(line);
+                continue;
+            }
+
+            char header[96];
+            int header_len = snprintf(header, sizeof(header), "MINE %d %lld %zu\n",
+                                      difficulty, deadline_ms, len);
+            int ok = write_all(fd, header, (size_t)header_len) && write_all(fd, line, len);
+            free(line);
+            if (!ok) {
+                break;
+            }
+            sent++;
+        }
+        // Half-close: the daemon hangs up once every request is answered
+        shutdown(fd, SHUT_WR);
+        fprintf(stderr, "📤 Sent %llu requests\n", sent);
+        _exit(0);
+    }
+
+    // Copy result lines to stdout until the daemon closes the connection
+    FILE* in = fdopen(fd, "r");
+    if (!in) {
+        close(fd);
+        return 1;
+    }
+    unsigned long long received = 0;
+    unsigned long long failed = 0;
+    char* line;
+    while ((line = nostr_read_line(in)) != NULL) {
+        fputs(line, stdout);
+        fflush(stdout);
+        received++;
+        // Only the top-level key marks a failure; the event itself may contain "error"
+        if (json_object_member(line, "error", NULL)) {
+            failed++;
+        }
+        free(line);
+    }
+    fclose(in);
+    waitpid(sender, NULL, 0);
+
+    fprintf(stderr, "📥 Received %llu results (%llu errors)\n", received, failed);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,489 @@
+/*
+ * NIP-13 mining engine shared by the standalone and parallel miners
+ */
+
+// clock_gettime under -std=c99
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include "nip13_engine.h"
+#include "nostr_event.h"
+
+uint64_t nip13_time_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+uint64_t nip13_wall_time_us(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000ULL + tv.tv_usec;
+}
+
+void nip13_print_layout(FILE* out, const nip13_layout_t* layout) {
+    fprintf(out, "📐 Nonce layout: tag %d of %d, %d digits, %zu block%s per attempt (%zu of %zu bytes cached, %d rounds precomputed)\n",
+            layout->tag_index + 1, layout->tag_count + 1, layout->nonce_width,
+            layout->blocks_per_attempt, layout->blocks_per_attempt == 1 ? "" : "s",
+            layout->cached_bytes, layout->total_bytes, layout->precomputed_rounds);
+}
+
+// Count leading zero bits in hash
+int count_leading_zeros(const uint8_t *hash) {
+    for (int i = 0; i < SHA256_DIGEST_SIZE; i += 4) {
+        uint32_t word = ((uint32_t)hash[i] << 24) | ((uint32_t)hash[i + 1] << 16) |
+                        ((uint32_t)hash[i + 2] << 8) | hash[i + 3];
+        if (word) {
+            return i * 8 + __builtin_clz(word);
+        }
+    }
+    return SHA256_DIGEST_SIZE * 8;
+}
+
+// Leading zero bits of a digest from its first two state words (capped at 64)
+int nip13_state_zeros(uint32_t h0, uint32_t h1) {
+    uint64_t top = ((uint64_t)h0 << 32) | h1;
+    return top ? __builtin_clzll(top) : 64;
+}
+
+// Digits needed so every nonce below end_nonce fits the slot
+int nip13_nonce_width(uint64_t end_nonce) {
+    int width = 1;
+    while (end_nonce >= 10 && width < NIP13_NONCE_MAX_WIDTH) {
+        end_nonce /= 10;
+        width++;
+    }
+    return width;
+}
+
+// Write nonce as exactly width zero-padded decimal digits (no terminator)
+void nip13_format_nonce(char* out, uint64_t nonce, int width) {
+    for (int i = width - 1; i >= 0; i--) {
+        out[i] = '0' + (nonce % 10);
+        nonce /= 10;
+    }
+}
+
+// Layout scoring for one candidate tag position and width
+static void plan_candidate(nip13_layout_t* best, int* have_best, int index, int count,
+                           size_t digits_pos, size_t base_len, int width, int counter_width, int target) {
+    // ["nonce","<digits>","<target>"] plus a comma when other tags follow or precede
+    size_t target_len = (size_t)snprintf(NULL, 0, "%d", target) + 3;
+    size_t total = base_len + 12 + width + target_len + (count > 0 ? 1 : 0);
+    size_t vary = digits_pos + (width - counter_width);
+    size_t boundary = vary - vary % SHA256_BLOCK_SIZE;
+    size_t blocks = (total - boundary + 9 + SHA256_BLOCK_SIZE - 1) / SHA256_BLOCK_SIZE;
+    int rounds = (int)((vary - boundary) / 4);
+
+    // Fewest blocks per attempt, then longest cached prefix, then the most
+    // rounds precomputed before the first changing word, then shortest nonce
+    if (*have_best) {
+        if (blocks != best->blocks_per_attempt) {
+            if (blocks > best->blocks_per_attempt) return;
+        } else if (boundary != best->cached_bytes) {
+            if (boundary < best->cached_bytes) return;
+        } else if (rounds != best->precomputed_rounds) {
+            if (rounds < best->precomputed_rounds) return;
+        } else if (width != best->nonce_width) {
+            if (width > best->nonce_width) return;
+        } else if (index < best->tag_index) {
+            return;
+        }
+    }
+
+    *have_best = 1;
+    best->tag_index = index;
+    best->tag_count = count;
+    best->nonce_width = width;
+    best->counter_width = counter_width;
+    best->target = target;
+    best->cached_bytes = boundary;
+    best->total_bytes = total;
+    best->blocks_per_attempt = blocks;
+    best->precomputed_rounds = rounds;
+}
+
+// Plan on a canonical serialization that has no nonce tag yet
+static int plan_canonical(const char* canonical, size_t tags_offset, uint64_t end_nonce, int target,
+                          int max_width, nip13_layout_t* layout) {
+    const char* tags = canonical + tags_offset;
+    int count = json_array_elements(tags, NULL, NULL, 0);
+    if (count < 0) {
+        return 0;
+    }
+
+    size_t* starts = malloc((count + 1) * sizeof(size_t));
+    size_t* ends = malloc((count + 1) * sizeof(size_t));
+    if (!starts || !ends) {
+        free(starts);
+        free(ends);
+        return 0;
+    }
+    json_array_elements(tags, starts, ends, count);
+
+    size_t base_len = strlen(canonical);
+    // A last scan starting at end_nonce - 1 leaves its lanes up to lanes - 1
+    // past the range, and the step after it moves them lanes further: the
+    // counter must hold end_nonce + 2 * SHA256_MAX_LANES without carrying
+    // out of its digits (saturating, so ranges near 2^64 get the full width)
+    uint64_t overshoot = 2 * SHA256_MAX_LANES;
+    uint64_t last_nonce = end_nonce > UINT64_MAX - overshoot ? UINT64_MAX : end_nonce + overshoot;
+    int counter_width = nip13_nonce_width(last_nonce);
+    int have_best = 0;
+
+    for (int index = 0; index <= count; index++) {
+        // Digits follow `["nonce","`, after a comma unless the tag goes first
+        size_t insert_at = tags_offset + (index == 0 ? 1 : ends[index - 1]);
+        size_t digits_pos = insert_at + (index > 0 ? 1 : 0) + 10;
+
+        // Zero padding can push the changing digits into a later block
+        for (int width = counter_width; width <= max_width || width == counter_width; width++) {
+            plan_candidate(layout, &have_best, index, count, digits_pos, base_len, width, counter_width, target);
+        }
+    }
+
+    free(starts);
+    free(ends);
+    return have_best;
+}
+
+// Choose the nonce tag position and width for nonces below end_nonce
+int nip13_plan_layout(const char* event_json, uint64_t end_nonce, int target, nip13_layout_t* layout) {
+    nostr_event_t ev;
+    if (!nostr_event_parse(event_json, &ev)) {
+        return 0;
+    }
+
+    size_t tags_offset;
+    char* canonical = nostr_event_canonical(event_json, &ev, NOSTR_NONCE_DROP, NULL, 0, &tags_offset, NULL);
+    nostr_event_free(&ev);
+    if (!canonical) {
+        return 0;
+    }
+
+    int ok = plan_canonical(canonical, tags_offset, end_nonce, target, NIP13_NONCE_MAX_WIDTH, layout);
+    free(canonical);
+    return ok;
+}
+
+// Build a template for nonces below end_nonce; returns 0 on malformed events or out of memory
+int nip13_template_init(nip13_template_t* tmpl, const char* event_json, uint64_t end_nonce, int target) {
+    return nip13_template_init_width(tmpl, event_json, end_nonce, target, NIP13_NONCE_MAX_WIDTH);
+}
+
+int nip13_template_init_width(nip13_template_t* tmpl, const char* event_json, uint64_t end_nonce, int target,
+                              int max_width) {
+    char slot[NIP13_NONCE_MAX_WIDTH + 1];
+    memset(tmpl, 0, sizeof(*tmpl));
+
+    // Tokenize once; both serializations below are built from the spans
+    nostr_event_t ev;
+    if (!nostr_event_parse(event_json, &ev)) {
+        return 0;
+    }
+
+    // Plan the nonce layout on the event without any existing nonce tag
+    size_t tags_offset;
+    char* canonical = nostr_event_canonical(event_json, &ev, NOSTR_NONCE_DROP, NULL, 0, &tags_offset, NULL);
+    if (!canonical || !plan_canonical(canonical, tags_offset, end_nonce, target, max_width, &tmpl->layout)) {
+        free(canonical);
+        nostr_event_free(&ev);
+        return 0;
+    }
+    free(canonical);
+
+    // Serialize the canonical event once with a zero-filled nonce slot
+    nip13_format_nonce(slot, 0, tmpl->layout.nonce_width);
+    slot[tmpl->layout.nonce_width] = '\0';
+    size_t value_pos;
+    canonical = nostr_event_canonical(event_json, &ev, tmpl->layout.tag_index, slot, tmpl->layout.target,
+                                      &tags_offset, &value_pos);
+    nostr_event_free(&ev);
+    if (!canonical) {
+        return 0;
+    }
+
+    size_t len = strlen(canonical);
+    if (len != tmpl->layout.total_bytes) {
+        free(canonical);
+        return 0;
+    }
+
+    // Only the low-order digits change; leading zeros stay in the prefix
+    size_t counter_pos = value_pos + tmpl->layout.nonce_width - tmpl->layout.counter_width;
+    size_t boundary = counter_pos - counter_pos % SHA256_BLOCK_SIZE;
+
+    // Hash the whole blocks before the changing digits once
+    sha256_init(&tmpl->midstate);
+    sha256_update(&tmpl->midstate, (const uint8_t*)canonical, boundary);
+
+    // Pre-pad the remaining blocks so attempts only run sha256_transform
+    size_t rest = len - boundary;
+    tmpl->tail_len = (rest + 9 + SHA256_BLOCK_SIZE - 1) / SHA256_BLOCK_SIZE * SHA256_BLOCK_SIZE;
+    tmpl->tail = calloc(tmpl->tail_len, 1);
+    if (!tmpl->tail) {
+        free(canonical);
+        return 0;
+    }
+    memcpy(tmpl->tail, canonical + boundary, rest);
+    tmpl->tail[rest] = 0x80;
+
+    uint64_t bit_count = (uint64_t)len * 8;
+    for (int i = 0; i < 8; i++) {
+        tmpl->tail[tmpl->tail_len - 1 - i] = bit_count & 0xff;
+        bit_count >>= 8;
+    }
+
+    tmpl->nonce_offset = counter_pos - boundary;
+
+    // Everything in tail block 0 before and around the changing words is fixed per job
+    sha256_precomp_init(&tmpl->first, tmpl->midstate.state, tmpl->tail,
+                        (int)(tmpl->nonce_offset / 4),
+                        (int)((tmpl->nonce_offset + tmpl->layout.counter_width - 1) / 4));
+    tmpl->canonical = canonical;
+    tmpl->canonical_len = len;
+    return 1;
+}
+
+void nip13_template_free(nip13_template_t* tmpl) {
+    free(tmpl->tail);
+    free(tmpl->canonical);
+    tmpl->tail = NULL;
+    tmpl->canonical = NULL;
+}
+
+// Event JSON carrying the nonce exactly as it was hashed (caller frees)
+char* nip13_template_event_json(const nip13_template_t* tmpl, const char* event_json, uint64_t nonce) {
+    char nonce_str[NIP13_NONCE_MAX_WIDTH + 1];
+    nip13_format_nonce(nonce_str, nonce, tmpl->layout.nonce_width);
+    nonce_str[tmpl->layout.nonce_width] = '\0';
+
+    nostr_event_t ev;
+    if (!nostr_event_parse(event_json, &ev)) {
+        return NULL;
+    }
+    char* result = nostr_event_json(event_json, &ev, tmpl->layout.tag_index, nonce_str, tmpl->layout.target);
+    nostr_event_free(&ev);
+    return result;
+}
+
+int nip13_cursor_init(nip13_cursor_t* cur, const nip13_template_t* tmpl) {
+    cur->tmpl = tmpl;
+    cur->tail = malloc(tmpl->tail_len);
+    if (!cur->tail) {
+        return 0;
+    }
+    memcpy(cur->tail, tmpl->tail, tmpl->tail_len);
+    cur->digits = (char*)cur->tail + tmpl->nonce_offset;
+    cur->nonce = 0;
+    return 1;
+}
+
+void nip13_cursor_free(nip13_cursor_t* cur) {
+    free(cur->tail);
+    cur->tail = NULL;
+}
+
+// Position the cursor on an arbitrary nonce
+void nip13_cursor_seek(nip13_cursor_t* cur, uint64_t nonce) {
+    nip13_format_nonce(cur->digits, nonce, cur->tmpl->layout.counter_width);
+    cur->nonce = nonce;
+}
+
+// Hash-and-test the cursor's current nonce straight from the state words
+int nip13_cursor_test(const nip13_cursor_t* cur, int difficulty, uint32_t* h0, uint32_t* h1) {
+    const nip13_template_t* tmpl = cur->tmpl;
+    size_t last = tmpl->tail_len - SHA256_BLOCK_SIZE;
+    uint32_t state[8];
+    uint32_t mask0, mask1;
+
+    memcpy(state, tmpl->midstate.state, sizeof(state));
+    sha256_zero_masks(difficulty, &mask0, &mask1);
+
+    // Block 0 starts from the per-job plan; a single-block tail is tested directly
+    sha256_compress_precomp(&tmpl->first, state, cur->tail);
+    if (last == 0) {
+        *h0 = state[0];
+        *h1 = state[1];
+        return (state[0] & mask0) == 0 && (state[1] & mask1) == 0;
+    }
+
+    for (size_t off = SHA256_BLOCK_SIZE; off < last; off += SHA256_BLOCK_SIZE) {
+        sha256_compress(state, cur->tail + off);
+    }
+    return sha256_compress_test(state, cur->tail + last, mask0, mask1, h0, h1);
+}
+
+// Hash the canonical event for the cursor's current nonce
+void nip13_cursor_hash(const nip13_cursor_t* cur, uint8_t* hash) {
+    sha256_ctx_t ctx = cur->tmpl->midstate;
+
+    for (size_t off = 0; off < cur->tmpl->tail_len; off += SHA256_BLOCK_SIZE) {
+        sha256_transform(&ctx, cur->tail + off);
+    }
+
+    sha256_state_to_digest(ctx.state, hash);
+}
+
+// Advance by n nonces with decimal carry across the digits
+void nip13_cursor_advance(nip13_cursor_t* cur, uint64_t n) {
+    char* digit = cur->digits + cur->tmpl->layout.counter_width - 1;
+    cur->nonce += n;
+
+    while (n > 0) {
+        int sum = (*digit - '0') + (int)(n % 10);
+        n /= 10;
+        if (sum >= 10) {
+            sum -= 10;
+            n++;
+        }
+        *digit-- = '0' + sum;
+    }
+}
+
+// Big-endian message word at byte offset off of a tail buffer
+static uint32_t tail_word(const uint8_t* tail, size_t off) {
+    return ((uint32_t)tail[off] << 24) | ((uint32_t)tail[off + 1] << 16) |
+           ((uint32_t)tail[off + 2] << 8) | tail[off + 3];
+}
+
+// Refresh the transposed nonce words from each lane's tail copy
+static void batch_load_nonce_words(nip13_batch_t* batch) {
+    for (size_t w = batch->nonce_word_first; w <= batch->nonce_word_last; w++) {
+        uint32_t* dst = batch->words + w * batch->lanes;
+        for (int lane = 0; lane < batch->lanes; lane++) {
+            dst[lane] = tail_word(batch->cursors[lane].tail, w * 4);
+        }
+    }
+}
+
+// Set up lanes for the fastest kernel (lanes 0) or exactly 1, 8 or 16 lanes
+int nip13_batch_init(nip13_batch_t* batch, const nip13_template_t* tmpl, int lanes) {
+    memset(batch, 0, sizeof(*batch));
+    batch->lanes = lanes ? sha256_multi_lookup(lanes, &batch->kernel) : sha256_multi_select(&batch->kernel);
+    if (!batch->lanes) {
+        return 0;
+    }
+
+    if (!nip13_batch_retarget(batch, tmpl)) {
+        nip13_batch_free(batch);
+        return 0;
+    }
+    return 1;
+}
+
+void nip13_batch_free(nip13_batch_t* batch) {
+    for (int lane = 0; lane < batch->lanes; lane++) {
+        nip13_cursor_free(&batch->cursors[lane]);
+    }
+    free(batch->words);
+    batch->words = NULL;
+    batch->capacity = 0;
+}
+
+// Point an initialized batch at another template, reusing its lanes
+int nip13_batch_retarget(nip13_batch_t* batch, const nip13_template_t* tmpl) {
+    size_t total_words = tmpl->tail_len / 4;
+
+    // Long-lived batches settle on the longest tail they have seen
+    if (tmpl->tail_len > batch->capacity) {
+        for (int lane = 0; lane < batch->lanes; lane++) {
+            uint8_t* grown = realloc(batch->cursors[lane].tail, tmpl->tail_len);
+            if (!grown) {
+                return 0;
+            }
+            batch->cursors[lane].tail = grown;
+        }
+        if (batch->kernel) {
+            uint32_t* words = realloc(batch->words, total_words * batch->lanes * sizeof(uint32_t));
+            if (!words) {
+                return 0;
+            }
+            batch->words = words;
+        }
+        batch->capacity = tmpl->tail_len;
+    }
+
+    batch->tmpl = tmpl;
+    for (int lane = 0; lane < batch->lanes; lane++) {
+        nip13_cursor_t* cur = &batch->cursors[lane];
+        cur->tmpl = tmpl;
+        memcpy(cur->tail, tmpl->tail, tmpl->tail_len);
+        cur->digits = (char*)cur->tail + tmpl->nonce_offset;
+        cur->nonce = 0;
+    }
+
+    batch->nonce_word_first = tmpl->nonce_offset / 4;
+    batch->nonce_word_last = (tmpl->nonce_offset + tmpl->layout.counter_width - 1) / 4;
+
+    if (batch->kernel) {
+        // Words outside the nonce slot are identical in every lane
+        for (size_t w = 0; w < total_words; w++) {
+            uint32_t value = tail_word(tmpl->tail, w * 4);
+            for (int lane = 0; lane < batch->lanes; lane++) {
+                batch->words[w * batch->lanes + lane] = value;
+            }
+        }
+    }
+
+    nip13_batch_seek(batch, 0);
+    return 1;
+}
+
+// Position lane 0 on nonce (lane i on nonce + i)
+void nip13_batch_seek(nip13_batch_t* batch, uint64_t nonce) {
+    for (int lane = 0; lane < batch->lanes; lane++) {
+        nip13_cursor_seek(&batch->cursors[lane], nonce + lane);
+    }
+    if (batch->kernel) {
+        batch_load_nonce_words(batch);
+    }
+}
+
+// Hash every lane below end_nonce; returns the number of attempts made
+int nip13_batch_scan(nip13_batch_t* batch, int difficulty, uint64_t end_nonce, uint32_t* hits) {
+    uint64_t nonce = nip13_batch_nonce(batch);
+    int active = batch->lanes;
+    if (nonce >= end_nonce) {
+        *hits = 0;
+        return 0;
+    }
+    if (end_nonce - nonce < (uint64_t)active) {
+        active = (int)(end_nonce - nonce);
+    }
+
+    if (batch->kernel) {
+        *hits = batch->kernel(batch->tmpl->midstate.state, &batch->tmpl->first, batch->words,
+                              batch->tmpl->tail_len / SHA256_BLOCK_SIZE, difficulty,
+                              batch->h0, batch->h1);
+    } else {
+        *hits = nip13_cursor_test(&batch->cursors[0], difficulty, &batch->h0[0], &batch->h1[0]);
+    }
+
+    if (active < 32) {
+        *hits &= (1u << active) - 1;
+    }
+    return active;
+}
+
+// Move every lane forward by the lane count
+void nip13_batch_next(nip13_batch_t* batch) {
+    if (batch->lanes == 1) {
+        nip13_cursor_next(&batch->cursors[0]);
+        return;
+    }
+    for (int lane = 0; lane < batch->lanes; lane++) {
+        nip13_cursor_advance(&batch->cursors[lane], batch->lanes);
+    }
+    batch_load_nonce_words(batch);
+}
+
+// Leading zero bits of a lane from the last scan (capped at 64)
+int nip13_batch_lane_zeros(const nip13_batch_t* batch, int lane) {
+    return nip13_state_zeros(batch->h0[lane], batch->h1[lane]);
+}
@@ -0,0 +1,161 @@
+/*
+ * NIP-13 mining engine shared by the standalone and parallel miners
+ * The canonical event is serialized once per job into a template with a
+ * fixed-width nonce slot. Each thread owns a copy of the blocks that follow
+ * the prefix midstate and increments the ASCII nonce digits in place, so an
+ * attempt costs no allocations and no string scans.
+ */
+
+#ifndef NIP13_ENGINE_H
+#define NIP13_ENGINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "sha256.h"
+#include "sha256_simd.h"
+
+#define NIP13_NONCE_MAX_WIDTH 20
+
+// Placement of the nonce tag, chosen to minimize blocks hashed per attempt
+typedef struct {
+    int tag_index;              // Position of the nonce tag among the other tags
+    int tag_count;              // Other tags in the event
+    int nonce_width;            // Digits in the nonce slot, including zero padding
+    int counter_width;          // Low-order digits that change during the search
+    int target;                 // Difficulty committed as the nonce tag's third element
+    size_t cached_bytes;        // Prefix hashed once into the midstate
+    size_t total_bytes;         // Length of the canonical serialization
+    size_t blocks_per_attempt;  // sha256_transform calls per nonce
+    int precomputed_rounds;     // Rounds of the first nonce block evaluated once per job
+} nip13_layout_t;
+
+// Per-job template: canonical event split at the last block boundary before the nonce
+typedef struct {
+    nip13_layout_t layout;
+    sha256_ctx_t midstate;      // State after the whole blocks before the changing digits
+    uint8_t* tail;              // Remaining bytes with SHA256 padding and length
+    size_t tail_len;            // Multiple of SHA256_BLOCK_SIZE
+    size_t nonce_offset;        // First changing nonce digit, relative to tail
+    sha256_precomp_t first;     // Nonce-independent rounds and schedule terms of tail block 0
+    char* canonical;            // Canonical serialization with a zero nonce
+    size_t canonical_len;
+} nip13_template_t;
+
+// Per-thread cursor over a template
+typedef struct {
+    const nip13_template_t* tmpl;
+    uint8_t* tail;              // Thread-private copy of the template tail
+    char* digits;               // Changing nonce digits inside tail
+    uint64_t nonce;
+} nip13_cursor_t;
+
+// Multi-lane view of a template: lane i hashes nonce + i
+typedef struct {
+    const nip13_template_t* tmpl;
+    int lanes;
+    sha256_multi_fn kernel;     // NULL for the scalar path
+    nip13_cursor_t cursors[SHA256_MAX_LANES];
+    uint32_t* words;            // Transposed tail words [block][word][lane]
+    size_t capacity;            // Tail bytes allocated per lane
+    size_t nonce_word_first;    // Tail words touched by the nonce digits
+    size_t nonce_word_last;
+    uint32_t h0[SHA256_MAX_LANES];  // First two state words of the last scan
+    uint32_t h1[SHA256_MAX_LANES];
+} nip13_batch_t;
+
+// Monotonic clock in microseconds, the clock pool deadlines are measured on
+uint64_t nip13_time_us(void);
+
+// Wall clock in microseconds, for created_at timestamps
+uint64_t nip13_wall_time_us(void);
+
+// Report where the nonce landed and how much work each attempt costs
+void nip13_print_layout(FILE* out, const nip13_layout_t* layout);
+
+// Count leading zero bits in hash
+int count_leading_zeros(const uint8_t *hash);
+
+// Leading zero bits of a digest from its first two state words (capped at 64)
+int nip13_state_zeros(uint32_t h0, uint32_t h1);
+
+// Digits needed so every nonce below end_nonce fits the slot
+int nip13_nonce_width(uint64_t end_nonce);
+
+// Write nonce as exactly width zero-padded decimal digits (no terminator)
+void nip13_format_nonce(char* out, uint64_t nonce, int width);
+
+// Choose the nonce tag position among the existing tags and the digit width.
+// Any existing nonce tag is replaced by ["nonce","<digits>","<target>"]. The
+// plan minimizes blocks per attempt, then maximizes the prefix cached in the
+// midstate.
+int nip13_plan_layout(const char* event_json, uint64_t end_nonce, int target, nip13_layout_t* layout);
+
+// Build a template for nonces below end_nonce whose nonce tag commits to
+// target (NIP-13); returns 0 on malformed events or out of memory
+int nip13_template_init(nip13_template_t* tmpl, const char* event_json, uint64_t end_nonce, int target);
+
+// As nip13_template_init, with the slot padded to at most max_width digits
+// (never fewer than end_nonce needs), for events published in bulk
+int nip13_template_init_width(nip13_template_t* tmpl, const char* event_json, uint64_t end_nonce, int target,
+                              int max_width);
+void nip13_template_free(nip13_template_t* tmpl);
+
+// Event JSON carrying the nonce exactly as it was hashed (caller frees)
+char* nip13_template_event_json(const nip13_template_t* tmpl, const char* event_json, uint64_t nonce);
+
+int nip13_cursor_init(nip13_cursor_t* cur, const nip13_template_t* tmpl);
+void nip13_cursor_free(nip13_cursor_t* cur);
+
+// Position the cursor on an arbitrary nonce
+void nip13_cursor_seek(nip13_cursor_t* cur, uint64_t nonce);
+
+// Hash-and-test the current nonce from the raw state words; only
+// state[0]/state[1] are produced, so winners need nip13_cursor_hash
+int nip13_cursor_test(const nip13_cursor_t* cur, int difficulty, uint32_t* h0, uint32_t* h1);
+
+// Full digest of the canonical event for the cursor's current nonce
+void nip13_cursor_hash(const nip13_cursor_t* cur, uint8_t* hash);
+
+// Advance by n nonces with decimal carry across the digits
+void nip13_cursor_advance(nip13_cursor_t* cur, uint64_t n);
+
+// Set up lanes for the fastest kernel (lanes 0) or exactly 1, 8 or 16 lanes
+int nip13_batch_init(nip13_batch_t* batch, const nip13_template_t* tmpl, int lanes);
+void nip13_batch_free(nip13_batch_t* batch);
+
+// Point an initialized batch at another template, reusing its lanes; buffers
+// only grow when the new tail is longer than any before. Returns 0 (leaving
+// the batch unusable until the next successful call) when growing fails.
+int nip13_batch_retarget(nip13_batch_t* batch, const nip13_template_t* tmpl);
+
+// Position lane 0 on nonce (lane i on nonce + i)
+void nip13_batch_seek(nip13_batch_t* batch, uint64_t nonce);
+
+// Hash every lane below end_nonce; returns the number of attempts made and
+// stores the mask of lanes with at least `difficulty` leading zero bits
+int nip13_batch_scan(nip13_batch_t* batch, int difficulty, uint64_t end_nonce, uint32_t* hits);
+
+// Move every lane forward by the lane count
+void nip13_batch_next(nip13_batch_t* batch);
+
+// Leading zero bits of a lane from the last scan (capped at 64)
+int nip13_batch_lane_zeros(const nip13_batch_t* batch, int lane);
+
+// Nonce of lane 0
+static inline uint64_t nip13_batch_nonce(const nip13_batch_t* batch) {
+    return batch->cursors[0].nonce;
+}
+
+// Advance to the next nonce by incrementing the ASCII digits in place
+static inline void nip13_cursor_next(nip13_cursor_t* cur) {
+    char* digit = cur->digits + cur->tmpl->layout.counter_width - 1;
+    while (*digit == '9') {
+        *digit-- = '0';
+    }
+    (*digit)++;
+    cur->nonce++;
+}
+
+#endif
@@ -1,9 +1,12 @@
 /*
  * Parallel NIP-13 Proof of Work Miner
- * Simple parallelization using pthreads - divides nonce space across cores
- * Based on the standalone version, adding minimal threading
+ * Command-line front-end over libnip13 (nip13_pool.h): the worker pool and
+ * jobs live in the library, this file parses arguments and prints results
  */
 
+// sigaction and the socket API under -std=c11
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -13,541 +16,653 @@
 #include <sys/time.h>
 #include <math.h>
 #include <pthread.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+
+#include "sha256.h"
+#include "nostr_event.h"
+#include "nip13_engine.h"
+#include "nip13_pool.h"
+#include "cpu_topology.h"
 
 // Number of threads - will be set to number of CPU cores
 static int num_threads = 0;
 
-// Global result tracking
-static volatile int solution_found = 0;
-static uint64_t global_found_nonce = 0;
-static pthread_mutex_t solution_mutex = PTHREAD_MUTEX_INITIALIZER;
-
-// Simplified SHA256 constants and functions (same as original)
-#define SHA256_DIGEST_SIZE 32
-#define SHA256_BLOCK_SIZE  64
-
-// SHA256 constants (from hashcat)
-static const uint32_t sha256_k[64] = {
-    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
-    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
-    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
-    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
-    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
-    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
-    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
-    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
-};
-
-// Rotate right
-#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
-
-// SHA256 functions (optimized versions from hashcat)
-#define CH(x, y, z)  (((x) & (y)) ^ (~(x) & (z)))
-#define MAJ(x, y, z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
-#define S0(x)        (ROTR(x,  2) ^ ROTR(x, 13) ^ ROTR(x, 22))
-#define S1(x)        (ROTR(x,  6) ^ ROTR(x, 11) ^ ROTR(x, 25))
-#define s0(x)        (ROTR(x,  7) ^ ROTR(x, 18) ^ ((x) >>  3))
-#define s1(x)        (ROTR(x, 17) ^ ROTR(x, 19) ^ ((x) >> 10))
-
-// SHA256 context
-typedef struct {
-    uint32_t state[8];
-    uint64_t count;
-    uint8_t buffer[64];
-} sha256_ctx_t;
-
-// Initialize SHA256 context
-void sha256_init(sha256_ctx_t *ctx) {
-    ctx->state[0] = 0x6a09e667;
-    ctx->state[1] = 0xbb67ae85;
-    ctx->state[2] = 0x3c6ef372;
-    ctx->state[3] = 0xa54ff53a;
-    ctx->state[4] = 0x510e527f;
-    ctx->state[5] = 0x9b05688c;
-    ctx->state[6] = 0x1f83d9ab;
-    ctx->state[7] = 0x5be0cd19;
-    ctx->count = 0;
-}
+// Get number of CPU cores
+int get_cpu_cores() {
+    return (int)sysconf(_SC_NPROCESSORS_ONLN);
+}
 
-// Process a single 512-bit block (optimized from hashcat)
-void sha256_transform(sha256_ctx_t *ctx, const uint8_t *data) {
-    uint32_t w[64];
-    uint32_t a, b, c, d, e, f, g, h;
-    uint32_t t1, t2;
-
-    // Prepare message schedule
-    for (int i = 0; i < 16; i++) {
-        w[i] = (data[i * 4] << 24) | (data[i * 4 + 1] << 16) |
-               (data[i * 4 + 2] << 8) | data[i * 4 + 3];
-    }
-
-    for (int i = 16; i < 64; i++) {
-        w[i] = s1(w[i - 2]) + w[i - 7] + s0(w[i - 15]) + w[i - 16];
-    }
-
-    // Initialize working variables
-    a = ctx->state[0];
-    b = ctx->state[1];
-    c = ctx->state[2];
-    d = ctx->state[3];
-    e = ctx->state[4];
-    f = ctx->state[5];
-    g = ctx->state[6];
-    h = ctx->state[7];
-
-    // Main loop (unrolled for performance like hashcat)
-    for (int i = 0; i < 64; i++) {
-        t1 = h + S1(e) + CH(e, f, g) + sha256_k[i] + w[i];
-        t2 = S0(a) + MAJ(a, b, c);
-        h = g;
-        g = f;
-        f = e;
-        e = d + t1;
-        d = c;
-        c = b;
-        b = a;
-        a = t1 + t2;
-    }
-
-    // Add compressed chunk to current hash value
-    ctx->state[0] += a;
-    ctx->state[1] += b;
-    ctx->state[2] += c;
-    ctx->state[3] += d;
-    ctx->state[4] += e;
-    ctx->state[5] += f;
-    ctx->state[6] += g;
-    ctx->state[7] += h;
-}
-
-// Update SHA256 with new data
-void sha256_update(sha256_ctx_t *ctx, const uint8_t *data, size_t len) {
-    size_t buffer_space = 64 - (ctx->count % 64);
-
-    ctx->count += len;
-
-    if (len >= buffer_space) {
-        memcpy(ctx->buffer + (64 - buffer_space), data, buffer_space);
-        sha256_transform(ctx, ctx->buffer);
-        data += buffer_space;
-        len -= buffer_space;
-
-        while (len >= 64) {
-            sha256_transform(ctx, data);
-            data += 64;
-            len -= 64;
-        }
-    }
-
-    if (len > 0) {
-        memcpy(ctx->buffer + (ctx->count % 64) - len, data, len);
-    }
-}
-
-// Finalize SHA256 and output digest
-void sha256_final(sha256_ctx_t *ctx, uint8_t *digest) {
-    uint64_t bit_count = ctx->count * 8;
-    size_t pad_len = (ctx->count % 64 < 56) ? (56 - ctx->count % 64) : (120 - ctx->count % 64);
-
-    uint8_t padding[64] = {0x80};
-    sha256_update(ctx, padding, pad_len);
-
-    // Append length in bits as big-endian 64-bit integer
-    uint8_t len_bytes[8];
-    for (int i = 7; i >= 0; i--) {
-        len_bytes[i] = bit_count & 0xff;
-        bit_count >>= 8;
-    }
-    sha256_update(ctx, len_bytes, 8);
-
-    // Output final hash
-    for (int i = 0; i < 8; i++) {
-        digest[i * 4] = (ctx->state[i] >> 24) & 0xff;
-        digest[i * 4 + 1] = (ctx->state[i] >> 16) & 0xff;
-        digest[i * 4 + 2] = (ctx->state[i] >> 8) & 0xff;
-        digest[i * 4 + 3] = ctx->state[i] & 0xff;
+// Report which CPUs the workers are pinned to
+void print_placement(FILE* out, const cpu_topology_t* topo, int threads) {
+    int cores = 0, siblings = 0;
+    for (int i = 0; i < threads && i < topo->count; i++) {
+        if (topo->cpus[i].smt_rank == 0) {
+            cores++;
+        } else {
+            siblings++;
+        }
     }
-}
 
-// Complete SHA256 hash in one call
-void sha256_hash(const uint8_t *data, size_t len, uint8_t *digest) {
-    sha256_ctx_t ctx;
-    sha256_init(&ctx);
-    sha256_update(&ctx, data, len);
-    sha256_final(&ctx, digest);
+    fprintf(out, "🧭 Placement: %d threads on %d physical cores + %d SMT siblings (%d packages, %d NUMA nodes%s)\n",
+            threads, cores, siblings, topo->packages, topo->nodes, topo->hybrid ? ", fastest cores first" : "");
+    fprintf(out, "   CPUs:");
+    for (int i = 0; i < threads; i++) {
+        const cpu_info_t* info = cpu_topology_place(topo, i);
+        fprintf(out, " %d", info->cpu);
+        if (info->node >= 0 && topo->nodes > 1) {
+            fprintf(out, "@n%d", info->node);
+        }
+    }
+    fprintf(out, "%s\n", threads > topo->count ? " (wrapped: more threads than CPUs)" : "");
 }
 
-// Count leading zero bits in hash
-int count_leading_zeros(const uint8_t *hash) {
-    int zeros = 0;
-    for (int i = 0; i < SHA256_DIGEST_SIZE; i++) {
-        if (hash[i] == 0) {
-            zeros += 8;
-        } else {
-            uint8_t byte = hash[i];
-            while ((byte & 0x80) == 0) {
-                zeros++;
-                byte <<= 1;
-            }
-            break;
+// Parameters nip13_job_create rejects, so a NULL job can be told apart from a malformed event
+static const char* job_params_error(const nip13_job_params_t* params) {
+    int tier_count = params->tiers ? params->tier_count : 0;
+    if (params->difficulty < 1 || params->difficulty > 64) {
+        return "Difficulty must be between 1 and 64 bits";
+    }
+    if (tier_count < 0 || tier_count > NIP13_MAX_TIERS) {
+        return "Too many tiers";
+    }
+    for (int i = 0; i < tier_count; i++) {
+        if (params->tiers[i] < 1 || (i > 0 && params->tiers[i] <= params->tiers[i - 1])) {
+            return "Tiers must be positive and in increasing order";
         }
     }
-    return zeros;
+    if (tier_count > 0 && params->tiers[tier_count - 1] != params->difficulty) {
+        return "The last tier must be the difficulty";
+    }
+    if (params->roll_window > NIP13_ROLL_MAX_WINDOW) {
+        return "Roll window is longer than 30 days";
+    }
+    if (!params->roll_window && params->end_nonce <= params->start_nonce) {
+        return "Empty nonce range";
+    }
+    return NULL;
 }
 
-// Convert hash to hex string
-void hash_to_hex(const uint8_t *hash, char *hex_str) {
-    for (int i = 0; i < SHA256_DIGEST_SIZE; i++) {
-        sprintf(hex_str + i * 2, "%02x", hash[i]);
+// Serialize the event into a pool job and report its nonce layout
+static nip13_job_t* create_job(nip13_pool_t* pool, const char* event_json, const nip13_job_params_t* params) {
+    const char* error = job_params_error(params);
+    if (error) {
+        printf("❌ Error: %s\n", error);
+        return NULL;
     }
-    hex_str[64] = '\0';
+    nip13_job_t* job = nip13_job_create(pool, event_json, params);
+    if (!job) {
+        printf("❌ Error: Malformed event JSON\n");
+        return NULL;
+    }
+    nip13_print_layout(stdout, nip13_job_layout(job));
+    printf("\n");
+    return job;
 }
 
-// Get current time in microseconds
-uint64_t get_time_us() {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    return tv.tv_sec * 1000000ULL + tv.tv_usec;
+// Event JSON for a proof, verified against a full re-serialization (caller frees)
+static char* verified_event(const nip13_job_t* job, const nip13_proof_t* proof, char* hash_hex) {
+    uint8_t hash[SHA256_DIGEST_SIZE];
+    char* event = nip13_job_event_json(job, proof);
+    if (event) {
+        calculate_nostr_event_id(event, hash);
+    } else {
+        memset(hash, 0xff, SHA256_DIGEST_SIZE);
+    }
+    hash_to_hex(hash, hash_hex);
+    if (memcmp(hash, proof->hash, SHA256_DIGEST_SIZE) != 0) {
+        printf("⚠️  Published hash does not match the re-serialized event\n");
+    }
+    return event;
 }
 
-// Simple JSON manipulation (find and replace nonce) - same as original
-char* update_nonce_in_json(const char* json, uint64_t nonce) {
-    // Find existing nonce or create new one
-    char* result = malloc(strlen(json) + 100); // Extra space for nonce
-    char nonce_str[32];
-    sprintf(nonce_str, "\"%llu\"", (unsigned long long)nonce);
+// Live progress (--progress, --metrics): a reporter thread samples the
+// workers' attempt counters, which they flush once per chunk anyway, and
+// the job being mined. The hot loop pays nothing extra.
+#define REPORT_INTERVAL_US 1000000ULL
 
-    // Look for existing nonce tag
-    char* nonce_pos = strstr(json, "\"nonce\"");
-    if (nonce_pos) {
-        // Find the value after "nonce":
-        char* value_start = strchr(nonce_pos, ':');
-        if (value_start) {
-            value_start++;
-            while (*value_start == ' ' || *value_start == '\t') value_start++;
+typedef struct {
+    nip13_pool_t* pool;
+    int to_stderr;
+    const char* metrics_path;       // Prometheus text file rewritten every interval, NULL for none
+    char* metrics_tmp;              // Written first, then renamed over metrics_path
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    int stop;
+    nip13_job_t* job;               // Job being mined, NULL between jobs (guarded by lock)
+    int difficulty;
+    int threads;
+    uint64_t* last;                 // Per-thread attempts at the previous sample
+    uint64_t* current;
+    double* rates;
+    uint64_t last_total;
+    uint64_t start_time;
+    uint64_t last_time;
+} reporter_t;
+
+static reporter_t* reporter = NULL;
+
+// Point the reporter at the job being mined; cleared before the job is freed
+static void report_job(nip13_job_t* job, int difficulty) {
+    if (!reporter) {
+        return;
+    }
+    pthread_mutex_lock(&reporter->lock);
+    reporter->job = job;
+    reporter->difficulty = difficulty;
+    pthread_mutex_unlock(&reporter->lock);
+}
 
-            char* value_end = value_start;
-            if (*value_start == '"') {
-                value_end = strchr(value_start + 1, '"') + 1;
-            } else {
-                while (*value_end && *value_end != ',' && *value_end != ']' && *value_end != '}') {
-                    value_end++;
-                }
-            }
+// Rewrite the metrics file; the rename keeps scrapers from reading half a file
+static void write_metrics(reporter_t* r, double rate, uint64_t total, double skew,
+                          int have_job, int best, uint64_t job_attempts, double eta) {
+    FILE* fp = fopen(r->metrics_tmp, "w");
+    if (!fp) {
+        return;
+    }
+    fprintf(fp, "# HELP nip13_hashrate Hashes per second over the last interval.\n");
+    fprintf(fp, "# TYPE nip13_hashrate gauge\n");
+    fprintf(fp, "nip13_hashrate %.0f\n", rate);
+    fprintf(fp, "# HELP nip13_attempts_total Hashes tried by all workers.\n");
+    fprintf(fp, "# TYPE nip13_attempts_total counter\n");
+    fprintf(fp, "nip13_attempts_total %llu\n", (unsigned long long)total);
+    fprintf(fp, "# HELP nip13_thread_hashrate Hashes per second of each worker over the last interval.\n");
+    fprintf(fp, "# TYPE nip13_thread_hashrate gauge\n");
+    for (int i = 0; i < r->threads; i++) {
+        fprintf(fp, "nip13_thread_hashrate{thread=\"%d\"} %.0f\n", i, r->rates[i]);
+    }
+    fprintf(fp, "# HELP nip13_thread_attempts_total Hashes tried by each worker.\n");
+    fprintf(fp, "# TYPE nip13_thread_attempts_total counter\n");
+    for (int i = 0; i < r->threads; i++) {
+        fprintf(fp, "nip13_thread_attempts_total{thread=\"%d\"} %llu\n", i, (unsigned long long)r->last[i]);
+    }
+    fprintf(fp, "# HELP nip13_thread_skew_ratio Spread of worker hash rates, (max - min) / mean.\n");
+    fprintf(fp, "# TYPE nip13_thread_skew_ratio gauge\n");
+    fprintf(fp, "nip13_thread_skew_ratio %.4f\n", skew);
+    if (have_job) {
+        fprintf(fp, "# HELP nip13_job_difficulty_bits Difficulty of the event being mined.\n");
+        fprintf(fp, "# TYPE nip13_job_difficulty_bits gauge\n");
+        fprintf(fp, "nip13_job_difficulty_bits %d\n", r->difficulty);
+        fprintf(fp, "# HELP nip13_job_best_bits Most leading zero bits seen so far.\n");
+        fprintf(fp, "# TYPE nip13_job_best_bits gauge\n");
+        fprintf(fp, "nip13_job_best_bits %d\n", best);
+        fprintf(fp, "# HELP nip13_job_attempts Hashes tried on the event being mined.\n");
+        fprintf(fp, "# TYPE nip13_job_attempts gauge\n");
+        fprintf(fp, "nip13_job_attempts %llu\n", (unsigned long long)job_attempts);
+        fprintf(fp, "# HELP nip13_job_eta_seconds Expected time to a proof at the current rate (2^d / rate).\n");
+        fprintf(fp, "# TYPE nip13_job_eta_seconds gauge\n");
+        fprintf(fp, "nip13_job_eta_seconds %.3f\n", eta);
+    }
+    if (fclose(fp) == 0) {
+        rename(r->metrics_tmp, r->metrics_path);
+    }
+}
 
-            // Replace the nonce value
-            strncpy(result, json, value_start - json);
-            result[value_start - json] = '\0';
-            strcat(result, nonce_str);
-            strcat(result, value_end);
+// One sample: rates over the interval since the last one
+static void reporter_sample(reporter_t* r, int to_stderr) {
+    uint64_t now = nip13_time_us();
+    double interval = (now - r->last_time) / 1000000.0;
+    nip13_pool_attempts(r->pool, r->current, r->threads);
+
+    uint64_t total = 0;
+    double rate = 0;
+    double min_rate = 0;
+    double max_rate = 0;
+    for (int i = 0; i < r->threads; i++) {
+        r->rates[i] = interval > 0 ? (r->current[i] - r->last[i]) / interval : 0;
+        r->last[i] = r->current[i];
+        total += r->current[i];
+        rate += r->rates[i];
+        if (i == 0 || r->rates[i] < min_rate) {
+            min_rate = r->rates[i];
         }
-    } else {
-        // Add nonce to tags array
-        char* tags_pos = strstr(json, "\"tags\"");
-        if (tags_pos) {
-            char* array_start = strchr(tags_pos, '[');
-            if (array_start) {
-                strncpy(result, json, array_start - json + 1);
-                result[array_start - json + 1] = '\0';
-
-                // Add nonce tag
-                strcat(result, "[\"nonce\",");
-                strcat(result, nonce_str);
-                strcat(result, "]");
-
-                // Add rest of tags
-                char* rest = array_start + 1;
-                while (*rest == ' ' || *rest == '\t' || *rest == '\n') rest++;
-                if (*rest != ']') {
-                    strcat(result, ",");
-                    strcat(result, rest);
-                } else {
-                    strcat(result, rest);
-                }
-            }
+        if (i == 0 || r->rates[i] > max_rate) {
+            max_rate = r->rates[i];
         }
     }
+    r->last_time = now;
+    double skew = rate > 0 ? (max_rate - min_rate) / (rate / r->threads) : 0;
+
+    pthread_mutex_lock(&r->lock);
+    int have_job = r->job != NULL;
+    int difficulty = r->difficulty;
+    int best = 0;
+    uint64_t job_attempts = 0;
+    if (have_job) {
+        best = nip13_job_best(r->job);
+        nip13_job_poll(r->job, &job_attempts);
+    }
+    pthread_mutex_unlock(&r->lock);
 
-    return result;
-}
-
-// Update timestamp in JSON to make each benchmark iteration unique
-char* update_timestamp_in_json(const char* json, uint64_t timestamp) {
-    char* result = malloc(strlen(json) + 50); // Extra space for timestamp
-    char timestamp_str[32];
-    sprintf(timestamp_str, "%llu", (unsigned long long)timestamp);
-
-    // Look for existing created_at field
-    char* timestamp_pos = strstr(json, "\"created_at\"");
-    if (timestamp_pos) {
-        // Find the value after "created_at":
-        char* value_start = strchr(timestamp_pos, ':');
-        if (value_start) {
-            value_start++;
-            while (*value_start == ' ' || *value_start == '\t') value_start++;
-
-            char* value_end = value_start;
-            // Skip over the number value (no quotes for numbers)
-            while (*value_end && *value_end != ',' && *value_end != ']' && *value_end != '}') {
-                value_end++;
-            }
+    // Attempts are independent, so the expected wait for a proof stays 2^d /
+    // rate however long the search has run; the share of 2^d shows the luck
+    double expected = ldexp(1.0, difficulty);
+    double eta = rate > 0 ? expected / rate : -1;
 
-            // Replace the timestamp value
-            strncpy(result, json, value_start - json);
-            result[value_start - json] = '\0';
-            strcat(result, timestamp_str);
-            strcat(result, value_end);
+    if (r->metrics_path) {
+        write_metrics(r, rate, total, skew, have_job, best, job_attempts, eta);
+    }
+    // An idle pool (daemon between requests) stays quiet on stderr
+    if (!to_stderr || (!have_job && total == r->last_total)) {
+        r->last_total = total;
+        return;
+    }
+    r->last_total = total;
+    fprintf(stderr, "📈 %.0fs: %.2f MH/s", (now - r->start_time) / 1000000.0, rate / 1000000.0);
+    if (have_job) {
+        fprintf(stderr, ", %.1fM attempts (%.2f × 2^%d), best %d/%d bits", job_attempts / 1000000.0,
+                job_attempts / expected, difficulty, best, difficulty);
+        if (eta >= 0) {
+            fprintf(stderr, ", ETA %.1fs", eta);
         }
-    } else {
-        // If no created_at found, just return a copy
-        strcpy(result, json);
     }
-
-    return result;
+    if (r->threads > 1) {
+        fprintf(stderr, ", thread skew %.1f%% (%.2f-%.2f MH/s)", 100.0 * skew,
+                min_rate / 1000000.0, max_rate / 1000000.0);
+    }
+    fprintf(stderr, "\n");
 }
 
-// Thread data structure
-typedef struct {
-    int thread_id;
-    const char* event_json;
-    int difficulty;
-    uint64_t start_nonce;
-    uint64_t end_nonce;
-    uint64_t attempts;
-    uint64_t found_nonce;
-    int found_solution;
-} thread_data_t;
-
-// Worker thread function
-void* worker_thread(void* arg) {
-    thread_data_t* data = (thread_data_t*)arg;
-    uint64_t nonce = data->start_nonce;
-    uint8_t hash[SHA256_DIGEST_SIZE];
-    data->attempts = 0;
-    data->found_solution = 0;
-
-    while (nonce < data->end_nonce && !solution_found) {
-        // Update nonce in JSON
-        char* event_with_nonce = update_nonce_in_json(data->event_json, nonce);
-
-        // Hash the event
-        sha256_hash((uint8_t*)event_with_nonce, strlen(event_with_nonce), hash);
-        data->attempts++;
-
-        // Check if we found a valid proof
-        int leading_zeros = count_leading_zeros(hash);
-        if (leading_zeros >= data->difficulty) {
-            // Found a solution! Set global flag to stop other threads
-            pthread_mutex_lock(&solution_mutex);
-            if (!solution_found) {
-                solution_found = 1;
-                global_found_nonce = nonce;
-                data->found_nonce = nonce;
-                data->found_solution = 1;
-            }
-            pthread_mutex_unlock(&solution_mutex);
-
-            free(event_with_nonce);
-            break;
+static void* reporter_thread(void* arg) {
+    reporter_t* r = arg;
+    pthread_mutex_lock(&r->lock);
+    while (!r->stop) {
+        struct timespec until;
+        clock_gettime(CLOCK_REALTIME, &until);
+        until.tv_sec += REPORT_INTERVAL_US / 1000000;
+        until.tv_nsec += (REPORT_INTERVAL_US % 1000000) * 1000;
+        if (until.tv_nsec >= 1000000000L) {
+            until.tv_sec++;
+            until.tv_nsec -= 1000000000L;
         }
-
-        free(event_with_nonce);
-        nonce++;
+        if (pthread_cond_timedwait(&r->wake, &r->lock, &until) == 0 || r->stop) {
+            continue;
+        }
+        pthread_mutex_unlock(&r->lock);
+        reporter_sample(r, r->to_stderr);
+        pthread_mutex_lock(&r->lock);
     }
+    pthread_mutex_unlock(&r->lock);
 
+    // The metrics file is left with the totals of the whole run
+    if (r->metrics_path) {
+        reporter_sample(r, 0);
+    }
     return NULL;
 }
 
-// Get number of CPU cores
-int get_cpu_cores() {
-    return (int)sysconf(_SC_NPROCESSORS_ONLN);
+// Start sampling the pool; NULL (with a warning) when the thread cannot start
+static reporter_t* reporter_start(nip13_pool_t* pool, int to_stderr, const char* metrics_path) {
+    reporter_t* r = calloc(1, sizeof(reporter_t));
+    if (!r) {
+        return NULL;
+    }
+    r->pool = pool;
+    r->to_stderr = to_stderr;
+    r->metrics_path = metrics_path;
+    r->threads = nip13_pool_threads(pool);
+    r->last = calloc(r->threads, sizeof(uint64_t));
+    r->current = calloc(r->threads, sizeof(uint64_t));
+    r->rates = calloc(r->threads, sizeof(double));
+    if (metrics_path) {
+        r->metrics_tmp = malloc(strlen(metrics_path) + 5);
+        if (r->metrics_tmp) {
+            sprintf(r->metrics_tmp, "%s.tmp", metrics_path);
+        }
+    }
+    r->start_time = r->last_time = nip13_time_us();
+    nip13_pool_attempts(pool, r->last, r->threads);
+    pthread_mutex_init(&r->lock, NULL);
+    pthread_cond_init(&r->wake, NULL);
+
+    if (!r->last || !r->current || !r->rates || (metrics_path && !r->metrics_tmp) ||
+        pthread_create(&r->thread, NULL, reporter_thread, r) != 0) {
+        fprintf(stderr, "⚠️  Cannot start the progress reporter; continuing without it\n");
+        pthread_cond_destroy(&r->wake);
+        pthread_mutex_destroy(&r->lock);
+        free(r->last);
+        free(r->current);
+        free(r->rates);
+        free(r->metrics_tmp);
+        free(r);
+        return NULL;
+    }
+    return r;
 }
 
-// Parallel NIP-13 mining
-int nip13_mine_parallel(const char* event_json, int difficulty, uint64_t max_iterations, uint64_t* found_nonce) {
-    uint64_t start_time = get_time_us();
-    pthread_t* threads = malloc(num_threads * sizeof(pthread_t));
-    thread_data_t* thread_data = malloc(num_threads * sizeof(thread_data_t));
-
-    // Divide the nonce space among threads
-    uint64_t nonces_per_thread = max_iterations / num_threads;
-    uint64_t remainder = max_iterations % num_threads;
-
-    // Start worker threads
-    for (int i = 0; i < num_threads; i++) {
-        thread_data[i].thread_id = i;
-        thread_data[i].event_json = event_json;
-        thread_data[i].difficulty = difficulty;
-        thread_data[i].start_nonce = i * nonces_per_thread;
-        thread_data[i].end_nonce = (i + 1) * nonces_per_thread;
+// Stop before the pool it samples is destroyed
+static void reporter_stop(reporter_t* r) {
+    if (!r) {
+        return;
+    }
+    pthread_mutex_lock(&r->lock);
+    r->stop = 1;
+    pthread_cond_signal(&r->wake);
+    pthread_mutex_unlock(&r->lock);
+    pthread_join(r->thread, NULL);
+
+    pthread_cond_destroy(&r->wake);
+    pthread_mutex_destroy(&r->lock);
+    free(r->last);
+    free(r->current);
+    free(r->rates);
+    free(r->metrics_tmp);
+    free(r);
+}
 
-        // Give remainder nonces to the last thread
-        if (i == num_threads - 1) {
-            thread_data[i].end_nonce += remainder;
+// Timeline trace (--trace): the most recent events of each worker, about two
+// minutes of 2 ms chunks, written as Chrome trace-event JSON after the run
+#define TRACE_EVENTS_PER_THREAD (1 << 16)
+
+static const char* trace_path = NULL;
+
+// Stop the reporter, which samples the pool, and write the trace before the
+// workers are joined
+static void finish_pool(nip13_pool_t* pool, FILE* info) {
+    reporter_stop(reporter);
+    reporter = NULL;
+    if (trace_path) {
+        FILE* fp = fopen(trace_path, "w");
+        if (fp && nip13_pool_write_trace(pool, fp) && fclose(fp) == 0) {
+            fprintf(info, "🧵 Trace written to %s (open in chrome://tracing or ui.perfetto.dev)\n", trace_path);
+        } else {
+            if (fp) {
+                fclose(fp);
+            }
+            fprintf(info, "❌ Error: Cannot write trace to %s\n", trace_path);
         }
-
-        pthread_create(&threads[i], NULL, worker_thread, &thread_data[i]);
     }
+    nip13_pool_destroy(pool);
+}
 
-    // Wait for all threads to complete
-    for (int i = 0; i < num_threads; i++) {
-        pthread_join(threads[i], NULL);
+// Tiered search: what the tier reports need
+typedef struct {
+    uint64_t start_time;
+    const int* tiers;
+    int tier_count;
+} tier_report_t;
+
+// Report a tier the moment a worker reaches it
+static void report_tier(nip13_job_t* job, int tier, void* user) {
+    const tier_report_t* report = user;
+    nip13_proof_t proof;
+    char hash_hex[65];
+    if (!nip13_job_tier(job, tier, &proof)) {
+        return;
     }
+    hash_to_hex(proof.hash, hash_hex);
 
-    // Calculate total attempts and results
-    uint64_t total_attempts = 0;
-    int winning_thread = -1;
+    printf("🎖️  Tier %d/%d reached: %d bits at nonce %llu after %.3f seconds\n",
+           tier + 1, report->tier_count, report->tiers[tier], (unsigned long long)proof.nonce,
+           (nip13_time_us() - report->start_time) / 1000000.0);
+    printf("   🔒 %s\n", hash_hex);
+    fflush(stdout);
+}
 
-    for (int i = 0; i < num_threads; i++) {
-        total_attempts += thread_data[i].attempts;
-        if (thread_data[i].found_solution) {
-            winning_thread = i;
-        }
+// Mine toward difficulty; tiers (ascending, ending at difficulty) are
+// reported as they are first reached in the same pass. Without the top tier
+// the highest tier reached is returned instead. Returns 1 with the mined
+// event in *final_event, 0 if none, -1 for a malformed event.
+int nip13_mine_parallel(nip13_pool_t* pool, const char* event_json, int difficulty,
+                        const int* tiers, int tier_count, uint64_t max_iterations, char** final_event) {
+    uint64_t start_time = nip13_time_us();
+    tier_report_t report = { .start_time = start_time, .tiers = tiers, .tier_count = tier_count };
+    nip13_job_params_t params = { .difficulty = difficulty, .end_nonce = max_iterations,
+                                  .tiers = tiers, .tier_count = tier_count, .track_best = reporter != NULL,
+                                  .on_tier = report_tier, .user = &report };
+    *final_event = NULL;
+    nip13_job_t* job = create_job(pool, event_json, &params);
+    if (!job) {
+        return -1;
     }
 
-    uint64_t elapsed = get_time_us() - start_time;
+    // Threads pull chunks of the nonce space until one finds a proof
+    nip13_job_start(job);
+    report_job(job, difficulty);
+    nip13_status_t status = nip13_job_wait(job);
+    report_job(NULL, 0);
 
-    if (solution_found && winning_thread >= 0) {
-        uint8_t hash[SHA256_DIGEST_SIZE];
-        char hash_hex[65];
+    // Calculate total attempts and results
+    uint64_t total_attempts;
+    nip13_job_poll(job, &total_attempts);
+    uint64_t elapsed = nip13_time_us() - start_time;
+    nip13_proof_t proof;
+    int found = 0;
 
-        // Verify the solution
-        char* event_with_nonce = update_nonce_in_json(event_json, global_found_nonce);
-        sha256_hash((uint8_t*)event_with_nonce, strlen(event_with_nonce), hash);
-        hash_to_hex(hash, hash_hex);
-        int leading_zeros = count_leading_zeros(hash);
+    if (status == NIP13_JOB_FOUND && nip13_job_result(job, &proof)) {
+        char hash_hex[65];
+        *final_event = verified_event(job, &proof, hash_hex);
 
         printf("✅ Found valid proof!\n");
-        printf("🎯 Nonce: %llu (found by thread %d)\n", (unsigned long long)global_found_nonce, winning_thread);
+        printf("🎯 Nonce: %llu (found by thread %d)\n", (unsigned long long)proof.nonce, proof.worker);
         printf("🔒 Hash:  %s\n", hash_hex);
-        printf("⚡ Leading zeros: %d\n", leading_zeros);
+        printf("⚡ Leading zeros: %d\n", proof.zeros);
         printf("⏱️  Time: %.2f seconds\n", elapsed / 1000000.0);
         printf("🚀 Rate: %.2f MH/s (%.2f MH/s per thread)\n",
                (total_attempts / 1000000.0) / (elapsed / 1000000.0),
                (total_attempts / 1000000.0) / (elapsed / 1000000.0) / num_threads);
-        printf("📊 Total attempts: %llu across %d threads\n", total_attempts, num_threads);
+        printf("📊 Total attempts: %llu across %d threads\n", (unsigned long long)total_attempts, num_threads);
+        found = 1;
+    } else {
+        printf("❌ No valid proof found after %llu attempts across %d threads\n",
+               (unsigned long long)total_attempts, num_threads);
+        printf("⏱️  Time: %.2f seconds\n", elapsed / 1000000.0);
+        printf("🚀 Rate: %.2f MH/s\n", (total_attempts / 1000000.0) / (elapsed / 1000000.0));
 
-        *found_nonce = global_found_nonce;
-        free(event_with_nonce);
-        free(threads);
-        free(thread_data);
-        return 1;
+        // Fall back to the highest tier reached on the way
+        int tier = tier_count - 1;
+        while (tier >= 0 && !nip13_job_tier(job, tier, &proof)) {
+            tier--;
+        }
+        if (tier >= 0) {
+            printf("🎖️  Settling for tier %d/%d: %d bits at nonce %llu\n", tier + 1, tier_count,
+                   tiers[tier], (unsigned long long)proof.nonce);
+            *final_event = nip13_job_event_json(job, &proof);
+            found = 1;
+        }
+    }
+
+    nip13_job_free(job);
+    return found;
+}
+
+// Nonce space for time-bounded mining: the budget, not the range, ends the search
+#define BEST_MAX_NONCES 1000000000000ULL
+
+// Mine for a wall-clock budget and keep the best proof; stops early once
+// target_difficulty is reached. Returns the achieved difficulty (0 if none,
+// -1 for a malformed event).
+int nip13_mine_best_parallel(nip13_pool_t* pool, const char* event_json, int target_difficulty,
+                             uint64_t budget_ms, char** final_event) {
+    uint64_t start_time = nip13_time_us();
+    nip13_job_params_t params = { .difficulty = target_difficulty, .end_nonce = BEST_MAX_NONCES,
+                                  .deadline_us = start_time + budget_ms * 1000, .keep_best = 1 };
+    *final_event = NULL;
+    nip13_job_t* job = create_job(pool, event_json, &params);
+    if (!job) {
+        return -1;
+    }
+
+    // Workers check the deadline between chunks (about 2 ms apart)
+    nip13_job_start(job);
+    report_job(job, target_difficulty);
+    nip13_status_t status = nip13_job_wait(job);
+    report_job(NULL, 0);
+
+    uint64_t total_attempts;
+    nip13_job_poll(job, &total_attempts);
+    uint64_t elapsed = nip13_time_us() - start_time;
+    nip13_proof_t proof;
+
+    if (!nip13_job_result(job, &proof)) {
+        printf("❌ No proof found within %llu ms\n", (unsigned long long)budget_ms);
+        nip13_job_free(job);
+        return 0;
     }
 
-    printf("❌ No valid proof found after %llu attempts across %d threads\n", total_attempts, num_threads);
-    printf("⏱️  Time: %.2f seconds\n", elapsed / 1000000.0);
-    printf("🚀 Rate: %.2f MH/s\n", (total_attempts / 1000000.0) / (elapsed / 1000000.0));
+    char hash_hex[65];
+    *final_event = verified_event(job, &proof, hash_hex);
 
-    free(threads);
-    free(thread_data);
-    return 0;
+    if (status == NIP13_JOB_FOUND) {
+        printf("✅ Reached target difficulty %d before the deadline\n", target_difficulty);
+    } else {
+        printf("⏰ Time budget spent; keeping the best proof\n");
+    }
+    printf("🎯 Nonce: %llu\n", (unsigned long long)proof.nonce);
+    printf("🔒 Hash:  %s\n", hash_hex);
+    printf("🏆 Achieved difficulty: %d bits (target %d)\n", proof.zeros, target_difficulty);
+    printf("⏱️  Time: %.3f seconds (budget %.3f)\n", elapsed / 1000000.0, budget_ms / 1000.0);
+    printf("🚀 Rate: %.2f MH/s (%.2f MH/s per thread)\n",
+           (total_attempts / 1000000.0) / (elapsed / 1000000.0),
+           (total_attempts / 1000000.0) / (elapsed / 1000000.0) / num_threads);
+    printf("📊 Total attempts: %llu across %d threads\n", (unsigned long long)total_attempts, num_threads);
+
+    nip13_job_free(job);
+    return proof.zeros;
 }
 
-// Parallel range mining for benchmark mode
-int nip13_mine_range_parallel(const char* event_json, int difficulty, uint64_t start_nonce,
-                             uint64_t end_nonce, uint64_t* found_nonce, uint64_t* attempts) {
-    solution_found = 0; // Reset global flag
-    pthread_t* threads = malloc(num_threads * sizeof(pthread_t));
-    thread_data_t* thread_data = malloc(num_threads * sizeof(thread_data_t));
+// Mine with created_at rolled forward from now across window_s seconds, one
+// template (and midstate) per timestamp. Returns 1 with the finished event in
+// *final_event, 0 when the window passes, -1 for a malformed event.
+int nip13_mine_roll_parallel(nip13_pool_t* pool, const char* event_json, int difficulty,
+                             uint64_t window_s, char** final_event) {
+    *final_event = NULL;
+    if (!json_object_member(event_json, "created_at", NULL)) {
+        printf("❌ Error: Rolling needs a created_at field in the event\n");
+        return -1;
+    }
 
-    uint64_t range_size = end_nonce - start_nonce;
-    uint64_t nonces_per_thread = range_size / num_threads;
-    uint64_t remainder = range_size % num_threads;
+    uint64_t start_time = nip13_time_us();
+    nip13_job_params_t params = { .difficulty = difficulty, .roll_window = window_s,
+                                  .roll_start = nip13_wall_time_us() / 1000000, .track_best = reporter != NULL };
+    nip13_job_t* job = create_job(pool, event_json, &params);
+    if (!job) {
+        return -1;
+    }
 
-    // Start worker threads
-    for (int i = 0; i < num_threads; i++) {
-        thread_data[i].thread_id = i;
-        thread_data[i].event_json = event_json;
-        thread_data[i].difficulty = difficulty;
-        thread_data[i].start_nonce = start_nonce + (i * nonces_per_thread);
-        thread_data[i].end_nonce = start_nonce + ((i + 1) * nonces_per_thread);
+    nip13_job_start(job);
+    report_job(job, difficulty);
+    nip13_status_t status = nip13_job_wait(job);
+    report_job(NULL, 0);
 
-        // Give remainder nonces to the last thread
-        if (i == num_threads - 1) {
-            thread_data[i].end_nonce += remainder;
-        }
+    uint64_t total_attempts;
+    nip13_job_poll(job, &total_attempts);
+    uint64_t elapsed = nip13_time_us() - start_time;
+    nip13_proof_t proof;
+    int found = 0;
+
+    if (status == NIP13_JOB_FOUND && nip13_job_result(job, &proof)) {
+        char hash_hex[65];
+        *final_event = verified_event(job, &proof, hash_hex);
 
-        pthread_create(&threads[i], NULL, worker_thread, &thread_data[i]);
+        printf("✅ Found valid proof!\n");
+        printf("🕰️  created_at: %llu (+%llu s into the window, %+lld s against the clock)\n",
+               (unsigned long long)proof.created_at, (unsigned long long)(proof.created_at - params.roll_start),
+               (long long)proof.created_at - (long long)(nip13_wall_time_us() / 1000000));
+        printf("🎯 Nonce: %llu (found by thread %d)\n", (unsigned long long)proof.nonce, proof.worker);
+        printf("🔒 Hash:  %s\n", hash_hex);
+        printf("⚡ Leading zeros: %d\n", proof.zeros);
+        found = 1;
+    } else {
+        printf("❌ No valid proof found within the %llu second window\n", (unsigned long long)window_s);
     }
 
-    // Wait for all threads to complete
-    for (int i = 0; i < num_threads; i++) {
-        pthread_join(threads[i], NULL);
+    printf("⏱️  Time: %.2f seconds over %llu timestamps\n", elapsed / 1000000.0,
+           (unsigned long long)nip13_job_timestamps(job));
+    printf("🚀 Rate: %.2f MH/s (%.2f MH/s per thread)\n",
+           (total_attempts / 1000000.0) / (elapsed / 1000000.0),
+           (total_attempts / 1000000.0) / (elapsed / 1000000.0) / num_threads);
+    printf("📊 Total attempts: %llu across %d threads\n", (unsigned long long)total_attempts, num_threads);
+
+    nip13_job_free(job);
+    return found;
+}
+
+// Parallel range mining for benchmark mode; -1 for a malformed event
+int nip13_mine_range_parallel(nip13_pool_t* pool, const char* event_json, int difficulty, uint64_t start_nonce,
+                             uint64_t end_nonce, uint64_t* found_nonce, uint64_t* attempts) {
+    nip13_job_params_t params = { .difficulty = difficulty, .start_nonce = start_nonce, .end_nonce = end_nonce };
+    nip13_job_t* job = nip13_job_create(pool, event_json, &params);
+    if (!job) {
+        return -1;
     }
 
+    // Threads pull chunks of the range until one finds a proof
+    nip13_job_start(job);
+    nip13_status_t status = nip13_job_wait(job);
+
     // Calculate total attempts
-    *attempts = 0;
-    for (int i = 0; i < num_threads; i++) {
-        *attempts += thread_data[i].attempts;
-    }
+    nip13_job_poll(job, attempts);
 
     int result = 0;
-    if (solution_found) {
-        *found_nonce = global_found_nonce;
+    nip13_proof_t proof;
+    if (status == NIP13_JOB_FOUND && nip13_job_result(job, &proof)) {
+        *found_nonce = proof.nonce;
         result = 1;
     }
-
-    free(threads);
-    free(thread_data);
+    nip13_job_free(job);
     return result;
 }
 
 // Function to increment timestamp in JSON string
 char* increment_timestamp_in_json(const char* json_str, int increment_seconds) {
-    // Find the "created_at" field
-    char* created_at_pos = strstr(json_str, "\"created_at\"");
-    if (!created_at_pos) {
+    const char* value = json_object_member(json_str, "created_at", NULL);
+    if (!value) {
         // If no created_at field, just return a copy
         char* result = malloc(strlen(json_str) + 1);
         strcpy(result, json_str);
         return result;
     }
-    
-    // Find the colon after "created_at"
-    char* colon_pos = strchr(created_at_pos, ':');
-    if (!colon_pos) {
-        char* result = malloc(strlen(json_str) + 1);
-        strcpy(result, json_str);
-        return result;
+    long current_timestamp = strtol(value, NULL, 10);
+    return set_created_at_in_json(json_str, (uint64_t)(current_timestamp + increment_seconds));
+}
+
+// Hardware counters between two pool snapshots, per hash (--perf)
+static void print_counters(const nip13_counters_t* before, const nip13_counters_t* after, uint64_t attempts) {
+    if (!attempts || !(after->valid & NIP13_COUNTER_CYCLES)) {
+        return;
     }
-    
-    // Skip whitespace after colon
-    char* value_start = colon_pos + 1;
-    while (*value_start == ' ' || *value_start == '\t') value_start++;
-    
-    // Find the end of the timestamp value (comma or closing brace)
-    char* value_end = value_start;
-    while (*value_end && *value_end != ',' && *value_end != '}' && *value_end != ' ') {
-        value_end++;
+    double cycles = (double)(after->cycles - before->cycles);
+    double seconds = (after->time_ns - before->time_ns) / 1e9;
+    printf("🔧 Hardware counters (user space, all workers):\n");
+    printf("   Cycles per hash: %.1f", cycles / attempts);
+    if (seconds > 0) {
+        printf(" (%.2f GHz effective)", cycles / seconds / 1e9);
     }
-    
-    // Parse the current timestamp
-    long current_timestamp = strtol(value_start, NULL, 10);
-    long new_timestamp = current_timestamp + increment_seconds;
-    
-    // Create new JSON with updated timestamp
-    size_t prefix_len = value_start - json_str;
-    size_t suffix_len = strlen(value_end);
-    char timestamp_str[32];
-    snprintf(timestamp_str, sizeof(timestamp_str), "%ld", new_timestamp);
-    
-    char* result = malloc(prefix_len + strlen(timestamp_str) + suffix_len + 1);
-    strncpy(result, json_str, prefix_len);
-    result[prefix_len] = '\0';
-    strcat(result, timestamp_str);
-    strcat(result, value_end);
-    
-    return result;
+    printf("\n");
+    if (after->valid & NIP13_COUNTER_INSTRUCTIONS) {
+        double instructions = (double)(after->instructions - before->instructions);
+        printf("   Instructions per hash: %.1f, IPC: %.2f\n", instructions / attempts,
+               cycles > 0 ? instructions / cycles : 0);
+    }
+    if (after->valid & NIP13_COUNTER_CACHE_MISSES) {
+        printf("   Cache misses per hash: %.6f\n", (double)(after->cache_misses - before->cache_misses) / attempts);
+    }
+    if (after->valid & NIP13_COUNTER_BRANCH_MISSES) {
+        printf("   Branch misses per hash: %.6f\n", (double)(after->branch_misses - before->branch_misses) / attempts);
+    }
+    printf("\n");
 }
 
 // Parallel benchmark mode
-int benchmark_mode_parallel(char* event_json, int difficulty, int target_solutions) {
+int benchmark_mode_parallel(nip13_pool_t* pool, char* event_json, int difficulty, int target_solutions) {
     printf("🚀 Parallel Benchmark Mode: Finding %d solutions at difficulty %d (%d threads)\n",
            target_solutions, difficulty, num_threads);
+    sha256_multi_fn kernel;
+    int lanes = sha256_multi_select(&kernel);
+    printf("🧮 SHA256 kernel: %s (%d lanes per thread)\n", sha256_multi_name(lanes), lanes);
     printf("📊 Measuring solutions per second with unique timestamps...\n\n");
 
     struct timeval start_time, current_time;
     gettimeofday(&start_time, NULL);
+    nip13_counters_t counters_start;
+    nip13_pool_counters(pool, &counters_start);
 
     int solutions_found = 0;
     uint64_t total_attempts = 0;
@@ -561,9 +676,16 @@ int benchmark_mode_parallel(char* event_json, int difficulty, int target_solutio
         uint64_t found_nonce;
         uint64_t attempts_this_round = 0;
 
-        // Mine with current timestamp
-        if (nip13_mine_range_parallel(working_json, difficulty, starting_nonce,
-                                    starting_nonce + 100000000ULL, &found_nonce, &attempts_this_round)) {
+        // Mine with current timestamp; the job serializes the event once for all threads
+        int found = nip13_mine_range_parallel(pool, working_json, difficulty, starting_nonce,
+                                              starting_nonce + 100000000ULL, &found_nonce, &attempts_this_round);
+        if (found < 0) {
+            printf("❌ Error: Malformed event JSON\n");
+            free(working_json);
+            return 0;
+        }
+
+        if (found) {
             solutions_found++;
             total_attempts += attempts_this_round;
             starting_nonce = 1; // Reset to beginning for next timestamp
@@ -607,6 +729,729 @@ int benchmark_mode_parallel(char* event_json, int difficulty, int target_solutio
     printf("   Average attempts per solution: %.0f\n", (double)total_attempts / solutions_found);
     printf("\n");
 
+    nip13_counters_t counters_end;
+    if (nip13_pool_counters(pool, &counters_end)) {
+        print_counters(&counters_start, &counters_end, total_attempts);
+    }
+
+    return 1;
+}
+
+// Statistical benchmark: a warmup sizes the fixed-work hashrate runs, then
+// every trial times that fixed work (no luck involved) and mines a few
+// seeded events to sample attempts per solution
+#define STATS_WARMUP_US 500000ULL
+#define STATS_TRIAL_US 250000ULL
+#define STATS_SOLUTIONS_PER_TRIAL 4
+
+// splitmix64: reproducible event sets from a seed on any platform
+static uint64_t stats_random(uint64_t* state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Summary of a sample: mean with its 95% confidence half-width and quantiles
+typedef struct {
+    double mean;
+    double ci95;
+    double stddev;
+    double median;
+    double p5;
+    double p95;
+} stats_summary_t;
+
+// Two-sided 95% Student t quantile for n - 1 degrees of freedom
+static double t_critical_95(int n) {
+    static const double table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    int df = n - 1;
+    return df < 1 ? 0 : df <= 30 ? table[df - 1] : 1.960;
+}
+
+// Linear interpolation between the closest ranks of a sorted sample
+static double quantile(const double* sorted, int n, double q) {
+    double pos = q * (n - 1);
+    int lo = (int)pos;
+    int hi = lo + 1 < n ? lo + 1 : lo;
+    return sorted[lo] + (sorted[hi] - sorted[lo]) * (pos - lo);
+}
+
+static stats_summary_t summarize(const double* values, int n) {
+    stats_summary_t s = { 0 };
+    double* sorted = malloc(n * sizeof(double));
+    memcpy(sorted, values, n * sizeof(double));
+    qsort(sorted, n, sizeof(double), compare_doubles);
+
+    for (int i = 0; i < n; i++) {
+        s.mean += values[i];
+    }
+    s.mean /= n;
+    for (int i = 0; i < n; i++) {
+        s.stddev += (values[i] - s.mean) * (values[i] - s.mean);
+    }
+    s.stddev = n > 1 ? sqrt(s.stddev / (n - 1)) : 0;
+    s.ci95 = n > 1 ? t_critical_95(n) * s.stddev / sqrt(n) : 0;
+    s.median = quantile(sorted, n, 0.5);
+    s.p5 = quantile(sorted, n, 0.05);
+    s.p95 = quantile(sorted, n, 0.95);
+    free(sorted);
+    return s;
+}
+
+// Attempts in a fixed-work run at 64 bits (never solved in practice), so the
+// rate measures the hashing alone; returns MH/s, negative for a malformed event
+static double stats_fixed_work(nip13_pool_t* pool, const char* event_json, uint64_t nonces) {
+    uint64_t found_nonce;
+    uint64_t attempts = 0;
+    uint64_t start = nip13_time_us();
+    int found = nip13_mine_range_parallel(pool, event_json, 64, 0, nonces, &found_nonce, &attempts);
+    uint64_t elapsed = nip13_time_us() - start;
+    return found < 0 ? -1 : (double)attempts / (elapsed ? elapsed : 1);
+}
+
+// Statistically sound benchmark: hash rate and solution luck measured apart
+int stats_mode_parallel(nip13_pool_t* pool, const char* event_json, int difficulty, int trials, uint64_t seed) {
+    sha256_multi_fn kernel;
+    int lanes = sha256_multi_select(&kernel);
+    double expected = ldexp(1.0, difficulty);
+    printf("🔬 Statistical Benchmark: %d trials at difficulty %d (%d threads, seed %llu)\n",
+           trials, difficulty, num_threads, (unsigned long long)seed);
+    printf("🧮 SHA256 kernel: %s (%d lanes per thread)\n\n", sha256_multi_name(lanes), lanes);
+
+    // Warmup: bring up clocks, caches and chunk sizes, then size the fixed work
+    uint64_t warmup_nonces = 1000000;
+    double rate = 0;
+    uint64_t warmup_start = nip13_time_us();
+    while (nip13_time_us() - warmup_start < STATS_WARMUP_US) {
+        rate = stats_fixed_work(pool, event_json, warmup_nonces);
+        if (rate < 0) {
+            printf("❌ Error: Malformed event JSON\n");
+            return 0;
+        }
+        warmup_nonces *= 2;
+    }
+    uint64_t trial_nonces = (uint64_t)(rate * STATS_TRIAL_US);
+    if (trial_nonces < 1000000) {
+        trial_nonces = 1000000;
+    }
+    printf("🔥 Warmup: %.2f s at %.2f MH/s (discarded); %llu attempts per hash rate trial\n\n",
+           (nip13_time_us() - warmup_start) / 1000000.0, rate, (unsigned long long)trial_nonces);
+
+    int max_solutions = trials * STATS_SOLUTIONS_PER_TRIAL;
+    double* rates = malloc(trials * sizeof(double));
+    double* attempts = malloc(max_solutions * sizeof(double));
+    double* seconds = malloc(max_solutions * sizeof(double));
+    int solutions = 0;
+    uint64_t rng = seed;
+    const char* created_at = json_object_member(event_json, "created_at", NULL);
+    uint64_t base_created_at = created_at ? strtoull(created_at, NULL, 10) : 0;
+
+    // Counters cover the fixed work only, which exhausts its range exactly
+    nip13_counters_t counters_start;
+    nip13_counters_t counters_end;
+    nip13_counters_t counters_fixed = { .valid = ~0u };
+    int counted = 1;
+
+    for (int trial = 0; trial < trials; trial++) {
+        nip13_pool_counters(pool, &counters_start);
+        rates[trial] = stats_fixed_work(pool, event_json, trial_nonces);
+        counted = nip13_pool_counters(pool, &counters_end) && counted;
+        counters_fixed.cycles += counters_end.cycles - counters_start.cycles;
+        counters_fixed.instructions += counters_end.instructions - counters_start.instructions;
+        counters_fixed.cache_misses += counters_end.cache_misses - counters_start.cache_misses;
+        counters_fixed.branch_misses += counters_end.branch_misses - counters_start.branch_misses;
+        counters_fixed.time_ns += counters_end.time_ns - counters_start.time_ns;
+        counters_fixed.valid &= counters_end.valid;
+
+        // The seed picks each event's created_at, so reruns mine the same events
+        uint64_t trial_attempts = 0;
+        uint64_t trial_tried = 0;
+        uint64_t trial_us = 0;
+        for (int i = 0; i < STATS_SOLUTIONS_PER_TRIAL; i++) {
+            uint64_t offset = stats_random(&rng) % (1ULL << 24);
+            char* event = set_created_at_in_json(event_json, base_created_at + offset);
+            if (!event) {
+                printf("❌ Error: Statistical benchmark needs a created_at field in the event\n");
+                free(rates);
+                free(attempts);
+                free(seconds);
+                return 0;
+            }
+
+            uint64_t found_nonce;
+            uint64_t tried = 0;
+            uint64_t start = nip13_time_us();
+            int found = nip13_mine_range_parallel(pool, event, difficulty, 0, 1000000000000ULL, &found_nonce, &tried);
+            uint64_t elapsed = nip13_time_us() - start;
+            free(event);
+            if (found <= 0) {
+                printf("💔 No solution within 10^12 attempts - difficulty may be too high\n");
+                free(rates);
+                free(attempts);
+                free(seconds);
+                return 0;
+            }
+
+            // The geometric sample is the winning nonce's position in the
+            // range. tried also counts the rest of every other worker's chunk
+            // after the win, which suits a hash rate but not this sample.
+            attempts[solutions] = (double)(found_nonce + 1);
+            seconds[solutions] = elapsed / 1000000.0;
+            solutions++;
+            trial_attempts += found_nonce + 1;
+            trial_tried += tried;
+            trial_us += elapsed;
+        }
+
+        printf("🧪 Trial %d/%d: %.2f MH/s, %d solutions at %.0f attempts/solution (solving at %.2f MH/s)\n",
+               trial + 1, trials, rates[trial], STATS_SOLUTIONS_PER_TRIAL,
+               (double)trial_attempts / STATS_SOLUTIONS_PER_TRIAL, trial_us ? (double)trial_tried / trial_us : 0);
+        fflush(stdout);
+    }
+
+    stats_summary_t r = summarize(rates, trials);
+    stats_summary_t a = summarize(attempts, solutions);
+    stats_summary_t t = summarize(seconds, solutions);
+
+    printf("\n📊 Hash rate over %d trials (fixed work, no solution luck):\n", trials);
+    printf("   Mean: %.3f MH/s ± %.3f (95%% CI), %.2f MH/s per thread\n", r.mean, r.ci95, r.mean / num_threads);
+    printf("   Median: %.3f, p5: %.3f, p95: %.3f MH/s (CV %.1f%%)\n", r.median, r.p5, r.p95,
+           r.mean > 0 ? 100.0 * r.stddev / r.mean : 0);
+    if (counted) {
+        nip13_counters_t none = { 0 };
+        print_counters(&none, &counters_fixed, trial_nonces * trials);
+    }
+
+    // Attempts per solution are geometric with mean 2^d; the sample mean only
+    // settles as 2^d / sqrt(n), so few solutions say little about the miner
+    printf("🎲 Attempts per solution over %d solutions:\n", solutions);
+    printf("   Expected: %.0f (2^%d), observed mean: %.0f ± %.0f (95%% CI), ratio %.3f\n",
+           expected, difficulty, a.mean, a.ci95, a.mean / expected);
+    printf("   Median: %.0f (expected %.0f), p95: %.0f (expected %.0f)\n",
+           a.median, expected * log(2.0), a.p95, expected * log(20.0));
+    if (fabs(a.mean - expected) <= a.ci95) {
+        printf("   ✅ Expectation inside the confidence interval\n");
+    } else {
+        printf("   ⚠️  Expectation outside the confidence interval\n");
+    }
+
+    printf("⏱️  Time per solution: mean %.4f ± %.4f s, median %.4f s, p95 %.4f s\n", t.mean, t.ci95, t.median, t.p95);
+    printf("🚀 Solutions per second: %.3f observed, %.3f expected from the hash rate (2^%d / rate)\n\n",
+           1.0 / t.mean, r.mean * 1000000.0 / expected, difficulty);
+
+    free(rates);
+    free(attempts);
+    free(seconds);
+    return 1;
+}
+
+// Connection of the Unix socket daemon; results are written back on fd
+typedef struct {
+    nip13_pool_t* pool;
+    int fd;
+    pthread_mutex_t write_lock;
+    pthread_cond_t slot_free;
+    int refs;                       // Reader thread plus requests in flight (guarded by write_lock)
+    int reading;                    // Reader still parsing frames (guarded by write_lock)
+    int closing;                    // Daemon shutting down: queue nothing more (guarded by write_lock)
+    int tracked;                    // Daemon has not joined the reader yet (guarded by write_lock)
+} serve_conn_t;
+
+// One event mined on the pool for the JSONL stream or a daemon client
+typedef struct {
+    nip13_job_t* job;
+    uint64_t seq;                   // Index of the event in its stream or connection
+    serve_conn_t* conn;             // NULL for the stdout stream
+} event_job_t;
+
+// JSONL stream mode: one event per input line, each result written as soon
+// as it is found. Events in flight are bounded so an endless stream is
+// never buffered whole.
+#define STREAM_JOBS_PER_THREAD 4
+
+static pthread_mutex_t stream_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t stream_slot_free = PTHREAD_COND_INITIALIZER;
+static int stream_in_flight = 0;
+static uint64_t stream_mined = 0;
+
+// Write the whole buffer, retrying short writes; a vanished client is ignored
+static void write_all(int fd, const char* buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+}
+
+// Write one result line to the job's sink; lines never interleave
+static void event_job_write(const event_job_t* ej, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+
+    if (!ej->conn) {
+        pthread_mutex_lock(&stream_lock);
+        vprintf(format, args);
+        fflush(stdout);
+        pthread_mutex_unlock(&stream_lock);
+    } else {
+        char line[512];
+        char* out = line;
+        va_list again;
+        va_copy(again, args);
+        int len = vsnprintf(line, sizeof(line), format, args);
+        if (len >= (int)sizeof(line)) {
+            out = malloc(len + 1);
+            if (out) {
+                vsnprintf(out, len + 1, format, again);
+            }
+        }
+        va_end(again);
+
+        if (out && len > 0) {
+            pthread_mutex_lock(&ej->conn->write_lock);
+            write_all(ej->conn->fd, out, (size_t)len);
+            pthread_mutex_unlock(&ej->conn->write_lock);
+        }
+        if (out != line) {
+            free(out);
+        }
+    }
+    va_end(args);
+}
+
+static void serve_conn_free(serve_conn_t* conn) {
+    pthread_cond_destroy(&conn->slot_free);
+    pthread_mutex_destroy(&conn->write_lock);
+    free(conn);
+}
+
+// Drop one reference; the last one closes the connection, which is freed
+// once the daemon has also joined its reader
+static void serve_conn_release(serve_conn_t* conn) {
+    pthread_mutex_lock(&conn->write_lock);
+    int refs = --conn->refs;
+    pthread_cond_signal(&conn->slot_free);
+    if (refs == 0) {
+        close(conn->fd);
+    }
+    int done = refs == 0 && !conn->tracked;
+    pthread_mutex_unlock(&conn->write_lock);
+
+    if (done) {
+        serve_conn_free(conn);
+    }
+}
+
+// Winner: emit the event with its nonce and id straight away
+static void event_job_found(nip13_job_t* job, void* user) {
+    event_job_t* ej = user;
+    nip13_proof_t proof;
+    char id_hex[65];
+    char* event_with_nonce = NULL;
+    if (nip13_job_result(job, &proof)) {
+        hash_to_hex(proof.hash, id_hex);
+        event_with_nonce = nip13_job_event_json(job, &proof);
+    }
+
+    char* final_event = event_with_nonce ? set_event_id_and_clear_sig(event_with_nonce, id_hex) : NULL;
+    if (final_event) {
+        event_job_write(ej, "{\"seq\":%llu,\"event\":%s}\n", (unsigned long long)ej->seq, final_event);
+    } else {
+        event_job_write(ej, "{\"seq\":%llu,\"error\":\"cannot serialize event\"}\n", (unsigned long long)ej->seq);
+    }
+    free(event_with_nonce);
+    free(final_event);
+}
+
+// Last worker out: report searches that ended without a proof and release the event
+static void event_job_retire(nip13_job_t* job, void* user) {
+    event_job_t* ej = user;
+    serve_conn_t* conn = ej->conn;
+    nip13_status_t status = nip13_job_poll(job, NULL);
+    int found = status == NIP13_JOB_FOUND;
+
+    if (!found) {
+        const char* reason = "no proof within max attempts";
+        if (status == NIP13_JOB_EXPIRED) {
+            reason = "deadline exceeded";
+        } else if (status == NIP13_JOB_CANCELLED) {
+            reason = "server shutting down";
+        } else if (status == NIP13_JOB_FAILED) {
+            reason = "out of memory";
+        }
+        event_job_write(ej, "{\"seq\":%llu,\"error\":\"%s\"}\n", (unsigned long long)ej->seq, reason);
+    }
+
+    nip13_job_free(job);
+    free(ej);
+
+    if (conn) {
+        serve_conn_release(conn);
+        return;
+    }
+
+    pthread_mutex_lock(&stream_lock);
+    stream_mined += found;
+    stream_in_flight--;
+    pthread_cond_signal(&stream_slot_free);
+    pthread_mutex_unlock(&stream_lock);
+}
+
+// Serialize an event into a pool job (NULL for malformed events)
+static event_job_t* event_job_create(nip13_pool_t* pool, const char* event_json, uint64_t seq, int difficulty,
+                                     uint64_t max_attempts, uint64_t deadline_us, serve_conn_t* conn) {
+    event_job_t* ej = malloc(sizeof(event_job_t));
+    if (!ej) {
+        return NULL;
+    }
+    ej->seq = seq;
+    ej->conn = conn;
+
+    // Serialize once per event; workers only touch the template tail
+    nip13_job_params_t params = { .difficulty = difficulty, .end_nonce = max_attempts,
+                                  .deadline_us = deadline_us, .on_found = event_job_found,
+                                  .on_done = event_job_retire, .user = ej };
+    ej->job = nip13_job_create(pool, event_json, &params);
+    if (!ej->job) {
+        free(ej);
+        return NULL;
+    }
+    return ej;
+}
+
+// Mine newline-delimited events from stdin across the worker pool
+int stream_mode(nip13_pool_t* pool, int difficulty, uint64_t max_attempts) {
+    uint64_t start_time = nip13_time_us();
+    uint64_t seq = 0;
+    char* line;
+
+    while ((line = nostr_read_line(stdin)) != NULL) {
+        size_t len = strlen(line);
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r' ||
+                           line[len - 1] == ' ' || line[len - 1] == '\t')) {
+            line[--len] = '\0';
+        }
+        if (len == 0) {
+            free(line);
+            continue;
+        }
+
+        event_job_t* ej = event_job_create(pool, line, seq, difficulty, max_attempts, 0, NULL);
+        free(line);
+        if (!ej) {
+            pthread_mutex_lock(&stream_lock);
+            printf("{\"seq\":%llu,\"error\":\"malformed event\"}\n", (unsigned long long)seq);
+            fflush(stdout);
+            pthread_mutex_unlock(&stream_lock);
+            seq++;
+            continue;
+        }
+        seq++;
+
+        pthread_mutex_lock(&stream_lock);
+        while (stream_in_flight >= nip13_pool_threads(pool) * STREAM_JOBS_PER_THREAD) {
+            pthread_cond_wait(&stream_slot_free, &stream_lock);
+        }
+        stream_in_flight++;
+        pthread_mutex_unlock(&stream_lock);
+
+        nip13_job_start(ej->job);
+    }
+
+    // Wait for the tail of the stream
+    pthread_mutex_lock(&stream_lock);
+    while (stream_in_flight > 0) {
+        pthread_cond_wait(&stream_slot_free, &stream_lock);
+    }
+    uint64_t mined = stream_mined;
+    pthread_mutex_unlock(&stream_lock);
+
+    double elapsed = (nip13_time_us() - start_time) / 1000000.0;
+    fprintf(stderr, "📦 Mined %llu of %llu events in %.2f seconds (%.1f events/sec)\n",
+            (unsigned long long)mined, (unsigned long long)seq, elapsed, elapsed > 0 ? mined / elapsed : 0.0);
+    return mined == seq;
+}
+
+// Daemon mode: clients on a Unix domain socket send framed requests
+//
+//   MINE <difficulty> <deadline_ms> <length>\n<length bytes of event JSON>
+//
+// and get one {"seq":N,"event":{...}} or {"seq":N,"error":"..."} line per
+// request, in completion order; seq counts requests on the connection.
+// deadline_ms is measured from receipt, 0 for none. Requests from every
+// client share the worker pool.
+#define SERVE_MAX_EVENT_BYTES (1 << 20)
+#define SERVE_MAX_NONCES 1000000000000ULL
+#define SERVE_BACKLOG 16
+
+static volatile sig_atomic_t serve_stop = 0;
+
+static void serve_signal(int sig) {
+    (void)sig;
+    serve_stop = 1;
+}
+
+// Per-connection reader: parse frames and queue them until the client hangs up
+static void* serve_reader(void* arg) {
+    serve_conn_t* conn = (serve_conn_t*)arg;
+    int in_fd = dup(conn->fd);
+    FILE* in = in_fd >= 0 ? fdopen(in_fd, "r") : NULL;
+    if (!in && in_fd >= 0) {
+        close(in_fd);
+    }
+    uint64_t seq = 0;
+    char* header;
+
+    while (in && (header = nostr_read_line(in)) != NULL) {
+        int difficulty = 0;
+        long long deadline_ms = -1;
+        long long length = -1;
+        int fields = sscanf(header, "MINE %d %lld %lld", &difficulty, &deadline_ms, &length);
+        free(header);
+
+        // A bad header loses the framing, so the connection ends here
+        if (fields != 3 || difficulty < 1 || difficulty > 32 || deadline_ms < 0 ||
+            length < 1 || length > SERVE_MAX_EVENT_BYTES) {
+            event_job_t reply = { .seq = seq, .conn = conn };
+            event_job_write(&reply, "{\"seq\":%llu,\"error\":\"bad request\"}\n", (unsigned long long)seq);
+            break;
+        }
+        uint64_t received = nip13_time_us();
+
+        char* event_json = malloc(length + 1);
+        if (!event_json || fread(event_json, 1, length, in) != (size_t)length) {
+            free(event_json);
+            break;
+        }
+        event_json[length] = '\0';
+
+        uint64_t deadline_us = deadline_ms > 0 ? received + (uint64_t)deadline_ms * 1000 : 0;
+        event_job_t* ej = event_job_create(conn->pool, event_json, seq, difficulty, SERVE_MAX_NONCES,
+                                           deadline_us, conn);
+        free(event_json);
+        if (!ej) {
+            event_job_t reply = { .seq = seq, .conn = conn };
+            event_job_write(&reply, "{\"seq\":%llu,\"error\":\"malformed event\"}\n", (unsigned long long)seq);
+            seq++;
+            continue;
+        }
+        seq++;
+
+        // Each request holds a reference; a client can keep a few per thread in flight
+        pthread_mutex_lock(&conn->write_lock);
+        while (!conn->closing && conn->refs - 1 >= nip13_pool_threads(conn->pool) * STREAM_JOBS_PER_THREAD) {
+            pthread_cond_wait(&conn->slot_free, &conn->write_lock);
+        }
+        int closing = conn->closing;
+        if (!closing) {
+            conn->refs++;
+        }
+        pthread_mutex_unlock(&conn->write_lock);
+
+        if (closing) {
+            event_job_write(ej, "{\"seq\":%llu,\"error\":\"server shutting down\"}\n", (unsigned long long)ej->seq);
+            nip13_job_free(ej->job);
+            free(ej);
+            break;
+        }
+        nip13_job_start(ej->job);
+    }
+
+    if (in) {
+        fclose(in);
+    }
+    pthread_mutex_lock(&conn->write_lock);
+    conn->reading = 0;
+    pthread_mutex_unlock(&conn->write_lock);
+    serve_conn_release(conn);
+    return NULL;
+}
+
+// Connection whose reader the daemon joins before the pool goes away
+typedef struct serve_client {
+    pthread_t reader;
+    serve_conn_t* conn;
+    struct serve_client* next;
+} serve_client_t;
+
+// Join the readers that are done (all of them when stopping); connections
+// whose requests are all answered are freed here
+static void serve_reap(serve_client_t** clients, int stopping) {
+    serve_client_t** link = clients;
+    while (*link) {
+        serve_client_t* client = *link;
+        pthread_mutex_lock(&client->conn->write_lock);
+        int reading = client->conn->reading;
+        pthread_mutex_unlock(&client->conn->write_lock);
+        if (reading && !stopping) {
+            link = &client->next;
+            continue;
+        }
+
+        pthread_join(client->reader, NULL);
+        pthread_mutex_lock(&client->conn->write_lock);
+        client->conn->tracked = 0;
+        int done = client->conn->refs == 0;
+        pthread_mutex_unlock(&client->conn->write_lock);
+        if (done) {
+            serve_conn_free(client->conn);
+        }
+        *link = client->next;
+        free(client);
+    }
+}
+
+// Replace a stale socket left by a daemon that is gone, but never another
+// kind of file or a socket someone still listens on
+static int serve_claim_path(const struct sockaddr_un* addr) {
+    struct stat st;
+    if (lstat(addr->sun_path, &st) != 0) {
+        return errno == ENOENT;
+    }
+    if (!S_ISSOCK(st.st_mode)) {
+        fprintf(stderr, "❌ Error: %s exists and is not a socket\n", addr->sun_path);
+        return 0;
+    }
+
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe < 0) {
+        perror("❌ socket");
+        return 0;
+    }
+    int live = connect(probe, (const struct sockaddr*)addr, sizeof(*addr)) == 0;
+    close(probe);
+    if (live) {
+        fprintf(stderr, "❌ Error: A daemon is already listening on %s\n", addr->sun_path);
+        return 0;
+    }
+    return unlink(addr->sun_path) == 0 || errno == ENOENT;
+}
+
+// Accept clients until SIGINT/SIGTERM; wait_mask is the signal mask to
+// restore while blocked in pselect (the signals stay blocked elsewhere)
+int serve_mode(nip13_pool_t* pool, const char* socket_path, const sigset_t* wait_mask) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "❌ Error: Socket path too long: %s\n", socket_path);
+        return 0;
+    }
+    strcpy(addr.sun_path, socket_path);
+
+    if (!serve_claim_path(&addr)) {
+        return 0;
+    }
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        perror("❌ socket");
+        return 0;
+    }
+    if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(listen_fd, SERVE_BACKLOG) != 0) {
+        perror("❌ bind");
+        close(listen_fd);
+        return 0;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = serve_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    // Clients that hang up early must not kill the daemon
+    signal(SIGPIPE, SIG_IGN);
+
+    fprintf(stderr, "🔌 Listening on %s (Ctrl-C to stop)\n", socket_path);
+
+    uint64_t clients = 0;
+    serve_client_t* readers = NULL;
+    while (!serve_stop) {
+        serve_reap(&readers, 0);
+
+        fd_set ready;
+        FD_ZERO(&ready);
+        FD_SET(listen_fd, &ready);
+        if (pselect(listen_fd + 1, &ready, NULL, NULL, NULL, wait_mask) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("❌ pselect");
+            break;
+        }
+
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            continue;
+        }
+
+        serve_conn_t* conn = malloc(sizeof(serve_conn_t));
+        if (!conn) {
+            close(fd);
+            continue;
+        }
+        serve_client_t* client = malloc(sizeof(serve_client_t));
+        if (!client) {
+            free(conn);
+            close(fd);
+            continue;
+        }
+        conn->pool = pool;
+        conn->fd = fd;
+        conn->refs = 1;
+        conn->reading = 1;
+        conn->closing = 0;
+        conn->tracked = 1;
+        pthread_mutex_init(&conn->write_lock, NULL);
+        pthread_cond_init(&conn->slot_free, NULL);
+
+        client->conn = conn;
+        if (pthread_create(&client->reader, NULL, serve_reader, conn) != 0) {
+            free(client);
+            conn->tracked = 0;
+            serve_conn_release(conn);
+            continue;
+        }
+        client->next = readers;
+        readers = client;
+        clients++;
+    }
+
+    // Stop every reader before the pool goes away: no frame is read after
+    // this, and a reader waiting for a slot answers its request itself
+    close(listen_fd);
+    for (serve_client_t* client = readers; client; client = client->next) {
+        // The socket is open for as long as its reader runs
+        pthread_mutex_lock(&client->conn->write_lock);
+        client->conn->closing = 1;
+        pthread_cond_broadcast(&client->conn->slot_free);
+        if (client->conn->reading) {
+            shutdown(client->conn->fd, SHUT_RD);
+        }
+        pthread_mutex_unlock(&client->conn->write_lock);
+    }
+    serve_reap(&readers, 1);
+    unlink(socket_path);
+    fprintf(stderr, "\n🛑 Shutting down after %llu connections\n", (unsigned long long)clients);
     return 1;
 }
 
@@ -615,12 +1460,61 @@ int main(int argc, char* argv[]) {
     // Initialize number of threads to CPU cores
     num_threads = get_cpu_cores();
 
+    // Leading options: placement mode pins workers to physical cores first,
+    // then SMT siblings; --perf counts hardware events in the benchmarks;
+    // --progress and --metrics report live hash rates; --trace records a
+    // per-thread timeline; the seed fixes the event set of the trials mode
+    int pin_threads = 0;
+    int count_events = 0;
+    int show_progress = 0;
+    const char* metrics_path = NULL;
+    uint64_t seed = 1;
+    while (argc > 1) {
+        int used;
+        if (strcmp(argv[1], "--pin") == 0) {
+            pin_threads = 1;
+            used = 1;
+        } else if (strcmp(argv[1], "--perf") == 0) {
+            count_events = 1;
+            used = 1;
+        } else if (strcmp(argv[1], "--progress") == 0) {
+            show_progress = 1;
+            used = 1;
+        } else if (strcmp(argv[1], "--metrics") == 0 && argc > 2) {
+            metrics_path = argv[2];
+            used = 2;
+        } else if (strcmp(argv[1], "--trace") == 0 && argc > 2) {
+            trace_path = argv[2];
+            used = 2;
+        } else if (strcmp(argv[1], "--seed") == 0 && argc > 2) {
+            seed = strtoull(argv[2], NULL, 10);
+            used = 2;
+        } else {
+            break;
+        }
+        argv[used] = argv[0];
+        argv += used;
+        argc -= used;
+    }
+
     if (argc < 2) {
-        printf("Usage: %s <event.json> [difficulty] [max_attempts|benchmark] [threads]\n", argv[0]);
+        printf("Usage: %s [--pin] [--perf] [--progress] [--metrics FILE] [--trace FILE] [--seed S] <event.json|--jsonl> [difficulty] [max_attempts|benchmark|trials|within|roll] [threads]\n", argv[0]);
+        printf("       %s [--pin] [--progress] [--metrics FILE] --serve <socket> [threads]\n", argv[0]);
+        printf("  --pin        - Pin threads per physical core, then per SMT sibling\n");
+        printf("  --perf       - Report cycles/hash, IPC and misses/hash from hardware counters in benchmarks\n");
+        printf("  --progress   - Every second: hash rate, best bits so far, ETA and thread skew on stderr\n");
+        printf("  --metrics F  - Rewrite F every second with the same figures in Prometheus text format\n");
+        printf("  --trace F    - Write a per-thread timeline (job start, chunks, solution, stop, exit) to F as Chrome trace JSON\n");
+        printf("  --seed S     - Seed of the event set mined by trials mode (default: 1)\n");
         printf("  event.json   - Nostr event JSON file\n");
-        printf("  difficulty   - Target difficulty in bits (default: 16)\n");
+        printf("  --jsonl      - Mine one event per stdin line; write {\"seq\":N,\"event\":{...}} lines as found\n");
+        printf("  --serve      - Run as a daemon on a Unix socket (see nip13_client)\n");
+        printf("  difficulty   - Target difficulty in bits (default: 16), or tiers like 20,24\n");
         printf("  max_attempts - Maximum attempts in millions (default: 100)\n");
         printf("  benchmark N  - Benchmark mode: find N solutions and measure solutions/sec\n");
+        printf("  trials N     - Statistical benchmark: warmup, then N trials of hash rate and solution luck with 95%% CIs\n");
+        printf("  within MS    - Mine for MS milliseconds and keep the best proof (difficulty up to 64 ends early)\n");
+        printf("  roll S       - Roll created_at forward from now across S seconds, never behind the clock\n");
         printf("  threads      - Number of threads (default: %d CPU cores)\n\n", num_threads);
         printf("Examples:\n");
         printf("  %s event.json 20 50              # Mine once, max 50M attempts\n", argv[0]);
@@ -628,20 +1522,151 @@ int main(int argc, char* argv[]) {
         printf("  %s event.json 18 100 8           # Mine with 8 threads\n", argv[0]);
         printf("  %s event.json 16 benchmark 5 4   # Benchmark with 4 threads\n", argv[0]);
         printf("  %s event.json 20 benchmark 10 1  # Single-threaded benchmark\n", argv[0]);
+        printf("  %s --seed 7 event.json 16 trials 20  # Hash rate and luck with confidence intervals\n", argv[0]);
+        printf("  %s event.json 32 within 500      # Best proof found in 500 ms\n", argv[0]);
+        printf("  %s event.json 20,22,24 500       # Report 20 and 22 bits on the way to 24\n", argv[0]);
+        printf("  %s event.json 32 roll 86400      # Day-long search, created_at kept current\n", argv[0]);
+        printf("  %s --pin event.json 16 benchmark 5  # Topology-aware placement\n", argv[0]);
+        printf("  %s --perf event.json 16 benchmark 5  # Cycles per hash and IPC\n", argv[0]);
+        printf("  %s --progress event.json 30 100000  # Watch a long search\n", argv[0]);
+        printf("  %s --trace trace.json event.json 16 benchmark 20  # Where wall time goes per solution\n", argv[0]);
+        printf("  %s --jsonl 16 10 < events.jsonl > mined.jsonl  # Stream many events\n", argv[0]);
+        printf("  %s --serve /tmp/nip13.sock 8     # Mining daemon with 8 threads\n", argv[0]);
         return 1;
     }
 
+    // Daemon mode: difficulty and deadline come with each request
+    if (strcmp(argv[1], "--serve") == 0) {
+        if (trace_path) {
+            printf("❌ Error: --trace needs a run that ends; it does not apply to --serve\n");
+            return 1;
+        }
+        if (argc < 3) {
+            printf("❌ Error: --serve needs a socket path\n");
+            return 1;
+        }
+        if (argc > 3) {
+            num_threads = atoi(argv[3]);
+        }
+        if (num_threads < 1 || num_threads > 128) {
+            printf("❌ Error: Thread count must be between 1 and 128\n");
+            return 1;
+        }
+
+        // Only the accept loop takes SIGINT/SIGTERM; workers and readers
+        // inherit the blocked mask
+        sigset_t stop_signals, wait_mask;
+        sigemptyset(&stop_signals);
+        sigaddset(&stop_signals, SIGINT);
+        sigaddset(&stop_signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &stop_signals, &wait_mask);
+
+        cpu_topology_t topology;
+        int have_topology = pin_threads && cpu_topology_load(&topology);
+        if (have_topology) {
+            print_placement(stderr, &topology, num_threads);
+        } else if (pin_threads) {
+            fprintf(stderr, "⚠️  CPU topology unavailable; threads stay unpinned\n");
+        }
+
+        nip13_pool_t* pool = nip13_pool_create(num_threads, have_topology ? &topology : NULL);
+        if (!pool) {
+            fprintf(stderr, "❌ Error: Cannot start %d worker threads\n", num_threads);
+            if (have_topology) {
+                cpu_topology_free(&topology);
+            }
+            return 1;
+        }
+
+        sha256_multi_fn kernel;
+        int lanes = sha256_multi_select(&kernel);
+        fprintf(stderr, "🧮 SHA256 kernel: %s (%d lanes per thread), %d threads\n",
+                sha256_multi_name(lanes), lanes, num_threads);
+        if (show_progress || metrics_path) {
+            reporter = reporter_start(pool, show_progress, metrics_path);
+        }
+
+        // Queued and running requests are answered with an error on the way out
+        int result = serve_mode(pool, argv[2], &wait_mask);
+        finish_pool(pool, stderr);
+        if (have_topology) {
+            cpu_topology_free(&topology);
+        }
+        return result ? 0 : 1;
+    }
+
     // Parse arguments
     char* json_file = argv[1];
+    int is_stream_mode = strcmp(json_file, "--jsonl") == 0;
     int difficulty = (argc > 2) ? atoi(argv[2]) : 16;
 
+    // "20,24" reports each difficulty as it is reached and mines toward the last
+    int tiers[NIP13_MAX_TIERS];
+    int tier_count = 0;
+    if (argc > 2 && strchr(argv[2], ',')) {
+        const char* p = argv[2];
+        while (*p && tier_count < NIP13_MAX_TIERS) {
+            char* end;
+            tiers[tier_count++] = (int)strtol(p, &end, 10);
+            if (end == p || (*end && *end != ',')) {
+                tier_count = -1;
+                break;
+            }
+            p = *end ? end + 1 : end;
+        }
+        if (tier_count < 0 || *p) {
+            printf("❌ Error: Tiers must be up to %d comma-separated difficulties\n", NIP13_MAX_TIERS);
+            return 1;
+        }
+        for (int i = 1; i < tier_count; i++) {
+            if (tiers[i] <= tiers[i - 1]) {
+                printf("❌ Error: Tiers must be in increasing order\n");
+                return 1;
+            }
+        }
+        difficulty = tiers[tier_count - 1];
+    }
+
+    // Stream mode keeps stdout for results only
+    FILE* info = is_stream_mode ? stderr : stdout;
+
     // Check for benchmark mode
     int is_benchmark_mode = 0;
     int target_solutions = 0;
     uint64_t max_attempts = 100000000ULL; // default 100M
 
+    // Statistical benchmark: trials of fixed-work hash rate plus seeded solves
+    int is_trials_mode = 0;
+    int trials = 0;
+
+    // Time-bounded mode: difficulty becomes a ceiling, the budget ends the search
+    int is_within_mode = 0;
+    long long budget_ms = 0;
+
+    // Rolling mode: created_at becomes a second search dimension
+    int is_roll_mode = 0;
+    long long window_s = 0;
+
     if (argc > 3) {
-        if (strcmp(argv[3], "benchmark") == 0) {
+        if (strcmp(argv[3], "roll") == 0) {
+            is_roll_mode = 1;
+            window_s = (argc > 4) ? atoll(argv[4]) : 3600;
+            if (argc > 5) {
+                num_threads = atoi(argv[5]);
+            }
+        } else if (strcmp(argv[3], "within") == 0) {
+            is_within_mode = 1;
+            budget_ms = (argc > 4) ? atoll(argv[4]) : 1000;
+            if (argc > 5) {
+                num_threads = atoi(argv[5]);
+            }
+        } else if (strcmp(argv[3], "trials") == 0) {
+            is_trials_mode = 1;
+            trials = (argc > 4) ? atoi(argv[4]) : 10;
+            if (argc > 5) {
+                num_threads = atoi(argv[5]);
+            }
+        } else if (strcmp(argv[3], "benchmark") == 0) {
             is_benchmark_mode = 1;
             target_solutions = (argc > 4) ? atoi(argv[4]) : 5;
             // Check for thread count after benchmark target
@@ -663,52 +1688,188 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    // Validate difficulty
-    if (difficulty < 1 || difficulty > 32) {
+    // Validate difficulty (a within-mode ceiling may use the full 64 bits the kernels test)
+    if (difficulty < 1 || difficulty > (is_within_mode ? 64 : 32)) {
+        printf("❌ Error: Difficulty must be between 1 and %d bits\n", is_within_mode ? 64 : 32);
+        return 1;
+    }
+
+    if (!is_benchmark_mode && !is_trials_mode && !is_within_mode && !is_roll_mode && max_attempts < 1) {
+        printf("❌ Error: Max attempts must be at least 1 million\n");
+        return 1;
+    }
+
+    if (is_within_mode && budget_ms < 1) {
+        printf("❌ Error: Time budget must be at least 1 ms\n");
+        return 1;
+    }
+
+    if (tier_count > 0 && tiers[0] < 1) {
         printf("❌ Error: Difficulty must be between 1 and 32 bits\n");
         return 1;
     }
 
+    if (tier_count > 0 && (is_within_mode || is_benchmark_mode || is_trials_mode || is_stream_mode)) {
+        printf("❌ Error: Tiers only apply to mining a single event file\n");
+        return 1;
+    }
+
+    if (is_roll_mode && (window_s < 1 || (uint64_t)window_s > NIP13_ROLL_MAX_WINDOW)) {
+        printf("❌ Error: Roll window must be between 1 and %llu seconds\n", NIP13_ROLL_MAX_WINDOW);
+        return 1;
+    }
+
+    if (is_roll_mode && (tier_count > 0 || is_stream_mode)) {
+        printf("❌ Error: Rolling only applies to mining a single event at one difficulty\n");
+        return 1;
+    }
+
+    if (is_within_mode && is_stream_mode) {
+        printf("❌ Error: Time-bounded mode needs an event file\n");
+        return 1;
+    }
+
     if (is_benchmark_mode && target_solutions < 1) {
         printf("❌ Error: Benchmark mode requires at least 1 solution\n");
         return 1;
     }
 
-    // Read event JSON
-    FILE* fp = fopen(json_file, "r");
-    if (!fp) {
-        printf("❌ Error: Cannot open file %s\n", json_file);
+    if ((is_benchmark_mode || is_trials_mode) && is_stream_mode) {
+        printf("❌ Error: Benchmark mode needs an event file\n");
+        return 1;
+    }
+
+    if (is_trials_mode && (trials < 2 || trials > 10000)) {
+        printf("❌ Error: Statistical benchmark needs between 2 and 10000 trials\n");
+        return 1;
+    }
+
+    // Read event JSON (stream mode reads events from stdin instead)
+    char* event_json = NULL;
+    if (!is_stream_mode) {
+        FILE* fp = fopen(json_file, "r");
+        if (!fp) {
+            printf("❌ Error: Cannot open file %s\n", json_file);
+            return 1;
+        }
+
+        fseek(fp, 0, SEEK_END);
+        long file_size = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+
+        event_json = malloc(file_size + 1);
+        fread(event_json, 1, file_size, fp);
+        event_json[file_size] = '\0';
+        fclose(fp);
+
+        // Remove any trailing whitespace
+        while (file_size > 0 && (event_json[file_size-1] == '\n' || event_json[file_size-1] == ' ')) {
+            event_json[--file_size] = '\0';
+        }
+    }
+
+    // Read the CPU topology for placement mode
+    cpu_topology_t topology;
+    int have_topology = 0;
+    if (pin_threads) {
+        have_topology = cpu_topology_load(&topology);
+        if (have_topology) {
+            print_placement(info, &topology, num_threads);
+        } else {
+            fprintf(info, "⚠️  CPU topology unavailable; threads stay unpinned\n");
+        }
+    }
+
+    // Workers are spawned once and reused for every job
+    nip13_pool_t* pool = nip13_pool_create(num_threads, have_topology ? &topology : NULL);
+    if (!pool) {
+        fprintf(info, "❌ Error: Cannot start %d worker threads\n", num_threads);
+        if (have_topology) {
+            cpu_topology_free(&topology);
+        }
+        free(event_json);
         return 1;
     }
 
-    fseek(fp, 0, SEEK_END);
-    long file_size = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
+    // Containers and VMs without a virtual PMU usually refuse perf_event_open
+    if (count_events && !nip13_pool_enable_counters(pool)) {
+        fprintf(info, "⚠️  Hardware counters unavailable (%s); continuing without them\n", strerror(errno));
+    }
 
-    char* event_json = malloc(file_size + 1);
-    fread(event_json, 1, file_size, fp);
-    event_json[file_size] = '\0';
-    fclose(fp);
+    if (show_progress || metrics_path) {
+        reporter = reporter_start(pool, show_progress, metrics_path);
+    }
 
-    // Remove any trailing whitespace
-    while (file_size > 0 && (event_json[file_size-1] == '\n' || event_json[file_size-1] == ' ')) {
-        event_json[--file_size] = '\0';
+    if (trace_path && !nip13_pool_enable_trace(pool, TRACE_EVENTS_PER_THREAD)) {
+        fprintf(info, "⚠️  Cannot allocate trace buffers; continuing without a trace\n");
+        trace_path = NULL;
+    }
+
+    if (is_stream_mode) {
+        sha256_multi_fn kernel;
+        int lanes = sha256_multi_select(&kernel);
+        fprintf(stderr, "🧮 SHA256 kernel: %s (%d lanes per thread), %d threads, difficulty %d\n",
+                sha256_multi_name(lanes), lanes, num_threads, difficulty);
+
+        int result = stream_mode(pool, difficulty, max_attempts);
+        finish_pool(pool, info);
+        if (have_topology) {
+            cpu_topology_free(&topology);
+        }
+        return result ? 0 : 1;
+    }
+
+    if (is_trials_mode) {
+        int result = stats_mode_parallel(pool, event_json, difficulty, trials, seed);
+        finish_pool(pool, info);
+        if (have_topology) {
+            cpu_topology_free(&topology);
+        }
+        free(event_json);
+        return result ? 0 : 1;
     }
 
     if (is_benchmark_mode) {
         // Run benchmark mode
-        int result = benchmark_mode_parallel(event_json, difficulty, target_solutions);
+        int result = benchmark_mode_parallel(pool, event_json, difficulty, target_solutions);
+        finish_pool(pool, info);
+        if (have_topology) {
+            cpu_topology_free(&topology);
+        }
         free(event_json);
         return result ? 0 : 1;
     } else {
-        printf("🔢 Max attempts: %.0f million across %d threads\n", max_attempts / 1000000.0, num_threads);
-        printf("\n");
+        sha256_multi_fn kernel;
+        int lanes = sha256_multi_select(&kernel);
+        if (is_within_mode) {
+            printf("⏳ Time budget: %lld ms across %d threads\n", budget_ms, num_threads);
+        } else if (is_roll_mode) {
+            printf("🕰️  Rolling created_at across %lld seconds with %d threads\n", window_s, num_threads);
+        } else {
+            printf("🔢 Max attempts: %.0f million across %d threads\n", max_attempts / 1000000.0, num_threads);
+        }
+        printf("🧮 SHA256 kernel: %s (%d lanes per thread)\n", sha256_multi_name(lanes), lanes);
 
         // Start parallel mining
-        uint64_t found_nonce;
-        if (nip13_mine_parallel(event_json, difficulty, max_attempts, &found_nonce)) {
+        char* final_event = NULL;
+        int found;
+        if (is_roll_mode) {
+            // Each timestamp gets its own template as the search reaches it
+            found = nip13_mine_roll_parallel(pool, event_json, difficulty, (uint64_t)window_s, &final_event);
+        } else if (is_within_mode) {
+            found = nip13_mine_best_parallel(pool, event_json, difficulty, (uint64_t)budget_ms, &final_event);
+            found = found > 0 ? 1 : found;
+        } else {
+            found = nip13_mine_parallel(pool, event_json, difficulty, tier_count > 0 ? tiers : NULL,
+                                        tier_count > 0 ? tier_count : 0, max_attempts, &final_event);
+        }
+        finish_pool(pool, info);
+        if (have_topology) {
+            cpu_topology_free(&topology);
+        }
+
+        if (found > 0) {
             // Output the final event with nonce
-            char* final_event = update_nonce_in_json(event_json, found_nonce);
             printf("📄 Final event:\n%s\n", final_event);
 
             // Save to output file
@@ -725,7 +1886,9 @@ int main(int argc, char* argv[]) {
             free(event_json);
             return 0;
         } else {
-            printf("\n💔 Mining failed - try lower difficulty or more attempts\n");
+            if (found == 0) {
+                printf("\n💔 Mining failed - try lower difficulty or more attempts\n");
+            }
             free(event_json);
             return 1;
         }
@@ -0,0 +1,912 @@
+/*
+ * Reentrant NIP-13 mining library: worker pool and job API
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "nip13_pool.h"
+#include "nostr_event.h"
+#include "perf_counters.h"
+#include "trace_ring.h"
+
+#define CACHE_LINE_SIZE 64
+
+// Nonce chunks claimed from the shared cursor: the size adapts so a chunk
+// takes about CHUNK_TARGET_US on the claiming thread
+#define CHUNK_MIN_NONCES 1024ULL
+#define CHUNK_MAX_NONCES (1ULL << 24)
+#define CHUNK_TARGET_US 2000
+
+// Rolled events are published one per second: their nonce slots get no zero
+// padding beyond the digits NIP13_ROLL_NONCES needs
+#define NIP13_ROLL_WIDTH 10
+
+// Thread data structure, one cache line per thread so counters never false-share
+typedef struct {
+    _Alignas(CACHE_LINE_SIZE) int thread_id;
+    nip13_pool_t* pool;
+    _Atomic uint64_t attempts;      // Lifetime attempts, flushed once per chunk, read by reporters
+    uint64_t chunks;
+    uint64_t chunk;                 // Current adaptive chunk size
+    nip13_batch_t batch;            // Lanes kept from job to job, retargeted per template
+    int has_batch;
+    perf_counters_t perf;           // Hardware counters, opened on the first job once enabled
+    int perf_state;                 // 0 closed, 1 counting, -1 could not be opened
+    trace_ring_t trace;             // Timeline events; trace.events is NULL unless tracing
+} thread_data_t;
+
+// Two-dimensional search over (created_at, nonce): job nonce g stands for
+// created_at first_timestamp + g / NIP13_ROLL_NONCES with nonce
+// g % NIP13_ROLL_NONCES, so every timestamp keeps a short nonce slot.
+// Templates, each with its own midstate, are built by the first worker to
+// reach their timestamp and live as long as the job.
+typedef struct {
+    uint64_t first_timestamp;
+    uint64_t timestamps;            // Window of created_at values
+    _Atomic(nip13_template_t*)* tmpls;  // One per timestamp, NULL until first used
+} mining_roll_t;
+
+// Job shared by its workers; the contended fields get their own cache lines
+struct nip13_job {
+    nip13_pool_t* pool;
+    uint32_t id;                    // Pool-wide start order, names the job in traces
+    char* event_json;
+    nip13_template_t tmpl;          // Unused when rolling
+    const nip13_template_t* first;  // Template of the first (or only) timestamp
+    mining_roll_t roll;             // roll.tmpls is NULL to mine tmpl alone
+    uint64_t created_at;            // created_at of the event when not rolling
+    int difficulty;
+    uint64_t start_nonce;
+    uint64_t end_nonce;
+    uint64_t deadline_us;           // nip13_time_us() after which the search stops, 0 for none
+    int keep_best;                  // Keep the best proof seen; difficulty only ends the search early
+    int track_best;                 // Record the best zeros below the difficulty for progress reports
+    int tiers[NIP13_MAX_TIERS];     // Ascending difficulties to report on the way, the last one equal to difficulty
+    int tier_count;
+    nip13_job_fn on_found;
+    nip13_job_fn on_done;
+    nip13_tier_fn on_tier;
+    void* user;
+
+    // Queue state, guarded by pool->lock
+    nip13_job_t* next;
+    int workers;                    // Threads currently mining this job
+    int queued;                     // Still open for new workers
+    int retired;                    // Finished, left by every worker and past on_done
+    int in_on_done;                 // on_done is running; nip13_job_free is deferred until it returns
+    int free_deferred;              // nip13_job_free was called from on_done
+
+    _Alignas(CACHE_LINE_SIZE) _Atomic uint64_t next_nonce;  // Start of the next unclaimed chunk
+    _Alignas(CACHE_LINE_SIZE) atomic_int winner;            // Thread that published the result, -1 while searching
+    atomic_int scan_bits;           // Bits tested by every scan; raised as keep_best, track_best and tier results land
+    atomic_int best_zeros;          // Zeros of the best hash so far (keep_best, track_best, tiers)
+    _Atomic uint64_t attempts;      // Flushed once per chunk by each worker
+    atomic_int expired;             // Stopped by the deadline
+    atomic_int cancelled;           // Stopped by nip13_job_cancel
+    atomic_int failed;              // A worker could not set up its lanes or a template
+    atomic_int status;              // nip13_status_t
+    uint64_t found_nonce;           // Written only by the winner (keep_best: under pool->lock)
+    uint8_t found_hash[SHA256_DIGEST_SIZE];
+
+    // First proof of each tier, written once under pool->lock
+    int tiers_reached;
+    uint64_t tier_nonce[NIP13_MAX_TIERS];
+    uint8_t tier_hash[NIP13_MAX_TIERS][SHA256_DIGEST_SIZE];
+};
+
+// Long-lived workers, parked until a job is queued
+struct nip13_pool {
+    pthread_t* threads;
+    thread_data_t* thread_data;
+    const cpu_topology_t* topology; // Pin workers in placement order when set
+    int num_threads;
+    pthread_mutex_t lock;
+    pthread_cond_t job_ready;       // A job was queued
+    pthread_cond_t job_done;        // A job retired
+    nip13_job_t* head;              // Open jobs, oldest first
+    nip13_job_t* tail;
+    int shutdown;
+    atomic_int abort;               // Abandon running jobs at the next chunk boundary
+    atomic_int count_events;        // Workers count hardware events around each job
+    nip13_counters_t counters;      // Totals of every counted job, guarded by lock
+    int counted;                    // Worker visits added to counters
+    uint32_t jobs_started;
+    uint64_t trace_origin;          // nip13_time_us() when tracing was enabled
+};
+
+// Adapt the chunk size so the next chunk takes about CHUNK_TARGET_US
+static uint64_t retune_chunk(uint64_t chunk, uint64_t elapsed_us) {
+    if (elapsed_us < CHUNK_TARGET_US / 2 && chunk < CHUNK_MAX_NONCES) {
+        return chunk * 2;
+    }
+    if (elapsed_us > CHUNK_TARGET_US * 2 && chunk > CHUNK_MIN_NONCES) {
+        return chunk / 2;
+    }
+    return chunk;
+}
+
+// keep_best: publish the best lane of a scan if it beats the shared record.
+// Improvements come about once per doubling of attempts, so the pool lock
+// is cheap here. Returns the lane's bit when it also reaches the difficulty.
+static uint32_t record_best(nip13_job_t* job, nip13_batch_t* batch, uint64_t base, uint32_t hits) {
+    int best_lane = -1;
+    int best = 0;
+    for (uint32_t mask = hits; mask; mask &= mask - 1) {
+        int lane = __builtin_ctz(mask);
+        int zeros = nip13_batch_lane_zeros(batch, lane);
+        if (zeros > best) {
+            best = zeros;
+            best_lane = lane;
+        }
+    }
+
+    int improved = 0;
+    pthread_mutex_lock(&job->pool->lock);
+    if (best > atomic_load_explicit(&job->best_zeros, memory_order_relaxed)) {
+        job->found_nonce = base + nip13_batch_nonce(batch) + best_lane;
+        nip13_cursor_hash(&batch->cursors[best_lane], job->found_hash);
+        atomic_store_explicit(&job->best_zeros, best, memory_order_relaxed);
+        atomic_store_explicit(&job->scan_bits, best + 1, memory_order_relaxed);
+        improved = 1;
+    }
+    pthread_mutex_unlock(&job->pool->lock);
+
+    return improved && best >= job->difficulty ? 1u << best_lane : 0;
+}
+
+// track_best: raise the best-so-far record without the pool lock (nothing
+// but the zero count is kept) and the bar with it, up to the difficulty.
+// Returns the lanes that reach the difficulty.
+static uint32_t record_progress(nip13_job_t* job, nip13_batch_t* batch, uint32_t hits) {
+    uint32_t solved = 0;
+    int best = 0;
+    for (uint32_t mask = hits; mask; mask &= mask - 1) {
+        int lane = __builtin_ctz(mask);
+        int zeros = nip13_batch_lane_zeros(batch, lane);
+        if (zeros >= job->difficulty) {
+            solved |= 1u << lane;
+        }
+        if (zeros > best) {
+            best = zeros;
+        }
+    }
+
+    int record = atomic_load_explicit(&job->best_zeros, memory_order_relaxed);
+    while (best > record) {
+        if (atomic_compare_exchange_weak_explicit(&job->best_zeros, &record, best,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+            // Racing stores may leave the bar a little low, costing a few extra hits
+            atomic_store_explicit(&job->scan_bits, best < job->difficulty ? best + 1 : job->difficulty,
+                                  memory_order_relaxed);
+            break;
+        }
+    }
+    return solved;
+}
+
+// Tiers: record the first proof of every tier the hit lanes reach, in nonce
+// order, then raise the bar to the lowest open tier. Returns the lane that
+// first reached the top tier, so exactly one thread goes on to claim the job.
+static uint32_t record_tiers(nip13_job_t* job, nip13_batch_t* batch, uint64_t base, uint32_t hits) {
+    uint32_t top = 0;
+    int first_new;
+    int last_new;
+
+    pthread_mutex_lock(&job->pool->lock);
+    first_new = job->tiers_reached;
+    for (uint32_t mask = hits; mask && job->tiers_reached < job->tier_count; mask &= mask - 1) {
+        int lane = __builtin_ctz(mask);
+        int zeros = nip13_batch_lane_zeros(batch, lane);
+        if (zeros < job->tiers[job->tiers_reached]) {
+            continue;
+        }
+
+        if (zeros > atomic_load_explicit(&job->best_zeros, memory_order_relaxed)) {
+            atomic_store_explicit(&job->best_zeros, zeros, memory_order_relaxed);
+        }
+
+        uint8_t hash[SHA256_DIGEST_SIZE];
+        nip13_cursor_hash(&batch->cursors[lane], hash);
+        while (job->tiers_reached < job->tier_count && zeros >= job->tiers[job->tiers_reached]) {
+            job->tier_nonce[job->tiers_reached] = base + nip13_batch_nonce(batch) + lane;
+            memcpy(job->tier_hash[job->tiers_reached], hash, SHA256_DIGEST_SIZE);
+            job->tiers_reached++;
+        }
+        if (job->tiers_reached == job->tier_count) {
+            top = 1u << lane;
+        } else {
+            atomic_store_explicit(&job->scan_bits, job->tiers[job->tiers_reached], memory_order_relaxed);
+        }
+    }
+    last_new = job->tiers_reached;
+    pthread_mutex_unlock(&job->pool->lock);
+
+    // Tier entries never change once written
+    if (job->on_tier) {
+        for (int tier = first_new; tier < last_new; tier++) {
+            job->on_tier(job, tier, job->user);
+        }
+    }
+    return top;
+}
+
+// Template for the index-th timestamp of a roll, built on first use; NULL
+// if the event cannot be serialized
+static const nip13_template_t* roll_template(nip13_job_t* job, uint64_t index) {
+    mining_roll_t* roll = &job->roll;
+    nip13_template_t* tmpl = atomic_load_explicit(&roll->tmpls[index], memory_order_acquire);
+    if (tmpl) {
+        return tmpl;
+    }
+
+    tmpl = malloc(sizeof(nip13_template_t));
+    char* json = set_created_at_in_json(job->event_json, roll->first_timestamp + index);
+    int ok = tmpl && json && nip13_template_init_width(tmpl, json, NIP13_ROLL_NONCES, job->difficulty,
+                                                            NIP13_ROLL_WIDTH);
+    free(json);
+    if (!ok) {
+        free(tmpl);
+        return NULL;
+    }
+
+    // Workers reaching a new timestamp together may both build it; one wins
+    nip13_template_t* expected = NULL;
+    if (!atomic_compare_exchange_strong_explicit(&roll->tmpls[index], &expected, tmpl,
+                                                 memory_order_acq_rel, memory_order_acquire)) {
+        nip13_template_free(tmpl);
+        free(tmpl);
+        tmpl = expected;
+    }
+    return tmpl;
+}
+
+// Never hand out a timestamp the clock has already passed: once a second
+// ticks over, the shared cursor jumps to the first nonce of the new second
+static void roll_follow_clock(nip13_job_t* job, uint64_t now_us) {
+    const mining_roll_t* roll = &job->roll;
+    uint64_t now = now_us / 1000000;
+    if (now <= roll->first_timestamp) {
+        return;
+    }
+    uint64_t floor = now - roll->first_timestamp < roll->timestamps ?
+                     (now - roll->first_timestamp) * NIP13_ROLL_NONCES : job->end_nonce;
+    uint64_t next = atomic_load_explicit(&job->next_nonce, memory_order_relaxed);
+    while (next < floor && !atomic_compare_exchange_weak_explicit(&job->next_nonce, &next, floor,
+                                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+// Claim chunks of a job until it is exhausted or solved
+static void mine_job(thread_data_t* data, nip13_job_t* job) {
+    nip13_batch_t* batch = &data->batch;
+
+    // Thread-private lanes over the template tail, set up once per thread and
+    // retargeted per job, so a stream of easy events costs no allocations
+    int ready = data->has_batch ? nip13_batch_retarget(batch, job->first)
+                                : (data->has_batch = nip13_batch_init(batch, job->first, 0));
+    if (!ready) {
+        atomic_store(&job->failed, 1);
+        atomic_store(&job->next_nonce, job->end_nonce);
+        return;
+    }
+
+    // Stop conditions are only read between chunks
+    while (atomic_load_explicit(&job->winner, memory_order_relaxed) < 0 &&
+           !atomic_load_explicit(&job->cancelled, memory_order_relaxed) &&
+           !atomic_load_explicit(&job->pool->abort, memory_order_relaxed)) {
+        uint64_t chunk_start_time = nip13_time_us();
+        if (job->deadline_us && chunk_start_time >= job->deadline_us) {
+            atomic_store_explicit(&job->expired, 1, memory_order_relaxed);
+            break;
+        }
+
+        if (job->roll.tmpls) {
+            roll_follow_clock(job, nip13_wall_time_us());
+        }
+
+        // Faster threads come back sooner and simply claim more chunks
+        uint64_t chunk = data->chunk;
+        uint64_t start = atomic_fetch_add_explicit(&job->next_nonce, chunk, memory_order_relaxed);
+        if (start >= job->end_nonce) {
+            break;
+        }
+        uint64_t end = job->end_nonce - start > chunk ? start + chunk : job->end_nonce;
+        uint64_t attempts = 0;
+
+        // Rolling: a chunk never crosses into the next timestamp. The rest
+        // of a chunk claimed across the boundary is skipped, a few million
+        // nonces out of each timestamp's range at most.
+        uint64_t base = 0;
+        if (job->roll.tmpls) {
+            uint64_t index = start / NIP13_ROLL_NONCES;
+            const nip13_template_t* tmpl = roll_template(job, index);
+            if (!tmpl || (tmpl != batch->tmpl && !nip13_batch_retarget(batch, tmpl))) {
+                atomic_store(&job->failed, 1);
+                atomic_store(&job->next_nonce, job->end_nonce);
+                break;
+            }
+            base = index * NIP13_ROLL_NONCES;
+            if (end > base + NIP13_ROLL_NONCES) {
+                end = base + NIP13_ROLL_NONCES;
+            }
+        }
+        int complete = end - start == chunk;
+
+        nip13_batch_seek(batch, start - base);
+        while (base + nip13_batch_nonce(batch) < end) {
+            // Hash one nonce per SIMD lane from the shared prefix midstate
+            // keep_best, track_best and tiers raise the bar as results come in
+            uint32_t hits;
+            int threshold = atomic_load_explicit(&job->scan_bits, memory_order_relaxed);
+            attempts += nip13_batch_scan(batch, threshold, end - base, &hits);
+
+            if (hits && (job->keep_best || job->tier_count || job->track_best)) {
+                hits = job->keep_best ? record_best(job, batch, base, hits)
+                       : job->tier_count ? record_tiers(job, batch, base, hits)
+                                         : record_progress(job, batch, hits);
+                if (!hits) {
+                    nip13_batch_next(batch);
+                    continue;
+                }
+            }
+
+            // Check if we found a valid proof
+            if (hits) {
+                int lane = __builtin_ctz(hits);
+                int expected = -1;
+
+                // First thread to swap in its id owns the result slot
+                if (atomic_compare_exchange_strong_explicit(&job->winner, &expected, data->thread_id,
+                                                            memory_order_acq_rel, memory_order_relaxed)) {
+                    if (data->trace.events) {
+                        trace_ring_record(&data->trace, TRACE_SOLUTION, job->id, nip13_time_us(), 0,
+                                          base + nip13_batch_nonce(batch) + lane, 0);
+                    }
+                    if (!job->keep_best) {
+                        job->found_nonce = base + nip13_batch_nonce(batch) + lane;
+                        nip13_cursor_hash(&batch->cursors[lane], job->found_hash);
+                    }
+                    if (job->on_found) {
+                        job->on_found(job, job->user);
+                    }
+                }
+                complete = 0;
+                break;
+            }
+
+            nip13_batch_next(batch);
+        }
+
+        // Counters are written once per chunk, not per attempt
+        atomic_fetch_add_explicit(&job->attempts, attempts, memory_order_relaxed);
+        atomic_store_explicit(&data->attempts, atomic_load_explicit(&data->attempts, memory_order_relaxed) + attempts,
+                              memory_order_relaxed);
+        data->chunks++;
+
+        uint64_t chunk_end_time = complete || data->trace.events ? nip13_time_us() : 0;
+        if (data->trace.events) {
+            trace_ring_record(&data->trace, TRACE_CHUNK, job->id, chunk_start_time,
+                              (uint32_t)(chunk_end_time - chunk_start_time), start, (uint32_t)(end - start));
+        }
+
+        // A chunk cut short by a hit says nothing about the hash rate; timing
+        // it would balloon the chunk and push back deadlines on later jobs
+        if (complete) {
+            data->chunk = retune_chunk(chunk, chunk_end_time - chunk_start_time);
+        }
+    }
+
+    // Tracing: when this worker noticed that the job was stopped elsewhere
+    if (data->trace.events) {
+        int winner = atomic_load_explicit(&job->winner, memory_order_relaxed);
+        if ((winner >= 0 && winner != data->thread_id) ||
+            atomic_load_explicit(&job->cancelled, memory_order_relaxed) ||
+            atomic_load_explicit(&job->expired, memory_order_relaxed) ||
+            atomic_load_explicit(&job->pool->abort, memory_order_relaxed)) {
+            trace_ring_record(&data->trace, TRACE_STOP, job->id, nip13_time_us(), 0, 0, 0);
+        }
+    }
+}
+
+// Next job for an idle worker (pool->lock held): the oldest job nobody has
+// started, otherwise help with the oldest open job
+static nip13_job_t* pick_job(nip13_pool_t* pool) {
+    for (nip13_job_t* job = pool->head; job; job = job->next) {
+        if (job->workers == 0) {
+            return job;
+        }
+    }
+    return pool->head;
+}
+
+// Stop handing out a finished job (pool->lock held)
+static void dequeue_job(nip13_pool_t* pool, nip13_job_t* job) {
+    nip13_job_t** link = &pool->head;
+    nip13_job_t* prev = NULL;
+    while (*link != job) {
+        prev = *link;
+        link = &(*link)->next;
+    }
+    *link = job->next;
+    if (pool->tail == job) {
+        pool->tail = prev;
+    }
+    job->queued = 0;
+}
+
+// How a job the last worker is leaving ended
+static nip13_status_t final_status(const nip13_job_t* job) {
+    if (atomic_load(&job->winner) >= 0) {
+        return NIP13_JOB_FOUND;
+    }
+    if (atomic_load(&job->failed)) {
+        return NIP13_JOB_FAILED;
+    }
+    if (atomic_load(&job->expired)) {
+        return NIP13_JOB_EXPIRED;
+    }
+    if (atomic_load(&job->cancelled) || atomic_load(&job->pool->abort)) {
+        return NIP13_JOB_CANCELLED;
+    }
+    return NIP13_JOB_EXHAUSTED;
+}
+
+// Counters at the start of a job: 1 when counting, 0 when counting is off,
+// -1 when this worker cannot count, which spoils the pool totals
+static int counters_begin(thread_data_t* data, perf_sample_t* sample) {
+    if (!atomic_load_explicit(&data->pool->count_events, memory_order_relaxed)) {
+        return 0;
+    }
+    if (data->perf_state == 0) {
+        data->perf_state = perf_counters_open(&data->perf) ? 1 : -1;
+    }
+    return data->perf_state > 0 && perf_counters_read(&data->perf, sample) ? 1 : -1;
+}
+
+// Extrapolated totals may step back slightly between two reads
+static uint64_t counter_delta(const perf_sample_t* before, const perf_sample_t* after, perf_event_t event) {
+    return after->values[event] > before->values[event] ? after->values[event] - before->values[event] : 0;
+}
+
+// Add what a worker counted on one job to the pool totals (pool->lock held)
+static void counters_add(nip13_pool_t* pool, const perf_sample_t* before, const perf_sample_t* after) {
+    nip13_counters_t* totals = &pool->counters;
+    totals->cycles += counter_delta(before, after, PERF_CYCLES);
+    totals->instructions += counter_delta(before, after, PERF_INSTRUCTIONS);
+    totals->cache_misses += counter_delta(before, after, PERF_CACHE_MISSES);
+    totals->branch_misses += counter_delta(before, after, PERF_BRANCH_MISSES);
+    totals->time_ns += after->time_ns > before->time_ns ? after->time_ns - before->time_ns : 0;
+    totals->valid &= before->valid & after->valid;
+    pool->counted++;
+}
+
+// Free everything a job owns
+static void job_release(nip13_job_t* job) {
+    if (job->roll.tmpls) {
+        for (uint64_t i = 0; i < job->roll.timestamps; i++) {
+            nip13_template_t* tmpl = atomic_load(&job->roll.tmpls[i]);
+            if (tmpl) {
+                nip13_template_free(tmpl);
+                free(tmpl);
+            }
+        }
+        free(job->roll.tmpls);
+    } else {
+        nip13_template_free(&job->tmpl);
+    }
+    free(job->event_json);
+    free(job);
+}
+
+// Worker thread function: park until a job is queued, mine it, report back
+static void* worker_thread(void* arg) {
+    thread_data_t* data = (thread_data_t*)arg;
+    nip13_pool_t* pool = data->pool;
+
+    // Pin before the first job: batch buffers are allocated and first touched
+    // by this thread, so the kernel places them on the local NUMA node
+    if (pool->topology) {
+        cpu_topology_pin_self(cpu_topology_place(pool->topology, data->thread_id)->cpu);
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        // Jobs still queued at shutdown are retired too; pool->abort makes
+        // mine_job return at once so their owners hear back
+        nip13_job_t* job;
+        while (!(job = pick_job(pool)) && !pool->shutdown) {
+            pthread_cond_wait(&pool->job_ready, &pool->lock);
+        }
+        if (!job) {
+            pthread_mutex_unlock(&pool->lock);
+            if (data->has_batch) {
+                nip13_batch_free(&data->batch);
+            }
+            if (data->perf_state > 0) {
+                perf_counters_close(&data->perf);
+            }
+            return NULL;
+        }
+        job->workers++;
+        pthread_mutex_unlock(&pool->lock);
+
+        // Counted per job, not per chunk: two reads for the whole visit
+        perf_sample_t before;
+        perf_sample_t after;
+        int counting = counters_begin(data, &before);
+        if (data->trace.events) {
+            trace_ring_record(&data->trace, TRACE_JOB_START, job->id, nip13_time_us(), 0, 0, 0);
+        }
+        mine_job(data, job);
+        if (data->trace.events) {
+            trace_ring_record(&data->trace, TRACE_JOB_EXIT, job->id, nip13_time_us(), 0, 0, 0);
+        }
+        if (counting > 0 && !perf_counters_read(&data->perf, &after)) {
+            counting = -1;
+        }
+
+        // The job is solved or exhausted once any worker leaves it
+        pthread_mutex_lock(&pool->lock);
+        if (counting > 0) {
+            counters_add(pool, &before, &after);
+        } else if (counting < 0) {
+            pool->counters.valid = 0;
+        }
+        if (job->queued) {
+            dequeue_job(pool, job);
+        }
+        if (--job->workers == 0) {
+            atomic_store(&job->status, final_status(job));
+
+            // Waiters wake only after on_done, which may free the job itself
+            int release = 0;
+            if (job->on_done) {
+                job->in_on_done = 1;
+                pthread_mutex_unlock(&pool->lock);
+                job->on_done(job, job->user);
+                pthread_mutex_lock(&pool->lock);
+                job->in_on_done = 0;
+                release = job->free_deferred;
+            }
+            if (release) {
+                pthread_mutex_unlock(&pool->lock);
+                job_release(job);
+                pthread_mutex_lock(&pool->lock);
+            } else {
+                job->retired = 1;
+                pthread_cond_broadcast(&pool->job_done);
+            }
+        }
+    }
+}
+
+nip13_pool_t* nip13_pool_create(int threads, const cpu_topology_t* topology) {
+    if (threads < 1) {
+        return NULL;
+    }
+    nip13_pool_t* pool = calloc(1, sizeof(nip13_pool_t));
+    if (!pool) {
+        return NULL;
+    }
+    pool->topology = topology;
+    pool->threads = malloc(threads * sizeof(pthread_t));
+    pool->thread_data = aligned_alloc(CACHE_LINE_SIZE, threads * sizeof(thread_data_t));
+    if (!pool->threads || !pool->thread_data) {
+        free(pool->threads);
+        free(pool->thread_data);
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->job_ready, NULL);
+    pthread_cond_init(&pool->job_done, NULL);
+
+    memset(pool->thread_data, 0, threads * sizeof(thread_data_t));
+    for (int i = 0; i < threads; i++) {
+        pool->thread_data[i].thread_id = i;
+        pool->thread_data[i].pool = pool;
+        pool->thread_data[i].chunk = CHUNK_MIN_NONCES;
+        if (pthread_create(&pool->threads[i], NULL, worker_thread, &pool->thread_data[i]) != 0) {
+            pool->num_threads = i;
+            nip13_pool_destroy(pool);
+            return NULL;
+        }
+    }
+    pool->num_threads = threads;
+    return pool;
+}
+
+void nip13_pool_destroy(nip13_pool_t* pool) {
+    if (!pool) {
+        return;
+    }
+    atomic_store(&pool->abort, 1);
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->job_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->num_threads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_cond_destroy(&pool->job_done);
+    pthread_cond_destroy(&pool->job_ready);
+    pthread_mutex_destroy(&pool->lock);
+    for (int i = 0; i < pool->num_threads; i++) {
+        trace_ring_free(&pool->thread_data[i].trace);
+    }
+    free(pool->threads);
+    free(pool->thread_data);
+    free(pool);
+}
+
+int nip13_pool_threads(const nip13_pool_t* pool) {
+    return pool->num_threads;
+}
+
+int nip13_pool_attempts(const nip13_pool_t* pool, uint64_t* attempts, int count) {
+    for (int i = 0; i < count && i < pool->num_threads; i++) {
+        attempts[i] = atomic_load_explicit(&pool->thread_data[i].attempts, memory_order_relaxed);
+    }
+    return pool->num_threads;
+}
+
+int nip13_pool_enable_trace(nip13_pool_t* pool, int events_per_thread) {
+    if (events_per_thread < 1) {
+        return 0;
+    }
+
+    // Workers take the lock before every job, so they see their rings from
+    // the next job on
+    pthread_mutex_lock(&pool->lock);
+    for (int i = 0; i < pool->num_threads; i++) {
+        trace_ring_t* ring = &pool->thread_data[i].trace;
+        if (!ring->events && !trace_ring_init(ring, (uint64_t)events_per_thread)) {
+            for (int j = 0; j < pool->num_threads; j++) {
+                trace_ring_free(&pool->thread_data[j].trace);
+            }
+            pthread_mutex_unlock(&pool->lock);
+            return 0;
+        }
+    }
+    pool->trace_origin = nip13_time_us();
+    pthread_mutex_unlock(&pool->lock);
+    return 1;
+}
+
+int nip13_pool_write_trace(nip13_pool_t* pool, FILE* out) {
+    trace_ring_t* rings = malloc(pool->num_threads * sizeof(trace_ring_t));
+    if (!rings) {
+        return 0;
+    }
+    pthread_mutex_lock(&pool->lock);
+    for (int i = 0; i < pool->num_threads; i++) {
+        rings[i] = pool->thread_data[i].trace;
+    }
+    int written = trace_ring_write_chrome(out, rings, pool->num_threads, pool->trace_origin);
+    pthread_mutex_unlock(&pool->lock);
+    free(rings);
+    return written;
+}
+
+int nip13_pool_enable_counters(nip13_pool_t* pool) {
+    // Probe on the calling thread: workers open theirs on their next job
+    perf_counters_t probe;
+    if (!perf_counters_open(&probe)) {
+        return 0;
+    }
+    perf_counters_close(&probe);
+
+    pthread_mutex_lock(&pool->lock);
+    memset(&pool->counters, 0, sizeof(pool->counters));
+    pool->counters.valid = NIP13_COUNTER_CYCLES | NIP13_COUNTER_INSTRUCTIONS |
+                           NIP13_COUNTER_CACHE_MISSES | NIP13_COUNTER_BRANCH_MISSES;
+    pool->counted = 0;
+    pthread_mutex_unlock(&pool->lock);
+    atomic_store(&pool->count_events, 1);
+    return 1;
+}
+
+int nip13_pool_counters(nip13_pool_t* pool, nip13_counters_t* counters) {
+    pthread_mutex_lock(&pool->lock);
+    *counters = pool->counters;
+    int counted = pool->counted > 0 && (pool->counters.valid & NIP13_COUNTER_CYCLES);
+    pthread_mutex_unlock(&pool->lock);
+    return counted;
+}
+
+nip13_job_t* nip13_job_create(nip13_pool_t* pool, const char* event_json, const nip13_job_params_t* params) {
+    int tier_count = params->tiers ? params->tier_count : 0;
+    if (params->difficulty < 1 || params->difficulty > 64 || tier_count < 0 || tier_count > NIP13_MAX_TIERS ||
+        params->roll_window > NIP13_ROLL_MAX_WINDOW ||
+        (!params->roll_window && params->end_nonce <= params->start_nonce)) {
+        return NULL;
+    }
+    for (int i = 0; i < tier_count; i++) {
+        if (params->tiers[i] < 1 || (i > 0 && params->tiers[i] <= params->tiers[i - 1])) {
+            return NULL;
+        }
+    }
+    if (tier_count > 0 && params->tiers[tier_count - 1] != params->difficulty) {
+        return NULL;
+    }
+
+    nip13_job_t* job = aligned_alloc(CACHE_LINE_SIZE, sizeof(nip13_job_t));
+    if (!job) {
+        return NULL;
+    }
+    memset(job, 0, sizeof(*job));
+    job->event_json = malloc(strlen(event_json) + 1);
+    if (!job->event_json) {
+        free(job);
+        return NULL;
+    }
+    strcpy(job->event_json, event_json);
+
+    job->pool = pool;
+    job->difficulty = params->difficulty;
+    job->start_nonce = params->start_nonce;
+    job->end_nonce = params->end_nonce;
+    job->deadline_us = params->deadline_us;
+    job->keep_best = params->keep_best;
+    job->track_best = params->track_best;
+    job->tier_count = tier_count;
+    if (tier_count > 0) {
+        memcpy(job->tiers, params->tiers, tier_count * sizeof(int));
+    }
+    job->on_found = params->on_found;
+    job->on_done = params->on_done;
+    job->on_tier = params->on_tier;
+    job->user = params->user;
+
+    if (params->roll_window) {
+        // Every timestamp gets its own template; events without created_at fail here
+        job->roll.first_timestamp = params->roll_start ? params->roll_start : nip13_wall_time_us() / 1000000;
+        job->roll.timestamps = params->roll_window;
+        job->roll.tmpls = calloc(params->roll_window, sizeof(*job->roll.tmpls));
+        job->end_nonce = params->roll_window * NIP13_ROLL_NONCES;
+        job->start_nonce = 0;
+        job->first = job->roll.tmpls ? roll_template(job, 0) : NULL;
+    } else {
+        // Serialize once per job; workers only touch the template tail
+        const char* created_at = json_object_member(job->event_json, "created_at", NULL);
+        job->created_at = created_at ? strtoull(created_at, NULL, 10) : 0;
+        job->first = nip13_template_init(&job->tmpl, job->event_json, job->end_nonce, job->difficulty) ? &job->tmpl : NULL;
+    }
+    if (!job->first) {
+        nip13_job_free(job);
+        return NULL;
+    }
+
+    atomic_store(&job->status, NIP13_JOB_PENDING);
+    return job;
+}
+
+void nip13_job_start(nip13_job_t* job) {
+    nip13_pool_t* pool = job->pool;
+    atomic_store(&job->next_nonce, job->start_nonce);
+    atomic_store(&job->winner, -1);
+    atomic_store(&job->scan_bits, job->keep_best ? 1 : job->tier_count ? job->tiers[0]
+                                  : job->track_best ? 1 : job->difficulty);
+    atomic_store(&job->status, NIP13_JOB_RUNNING);
+    job->next = NULL;
+    job->queued = 1;
+
+    pthread_mutex_lock(&pool->lock);
+    job->id = ++pool->jobs_started;
+    if (pool->tail) {
+        pool->tail->next = job;
+    } else {
+        pool->head = job;
+    }
+    pool->tail = job;
+    pthread_cond_broadcast(&pool->job_ready);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+nip13_status_t nip13_job_wait(nip13_job_t* job) {
+    nip13_pool_t* pool = job->pool;
+    pthread_mutex_lock(&pool->lock);
+    while (!job->retired && atomic_load(&job->status) != NIP13_JOB_PENDING) {
+        pthread_cond_wait(&pool->job_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return (nip13_status_t)atomic_load(&job->status);
+}
+
+nip13_status_t nip13_job_poll(const nip13_job_t* job, uint64_t* attempts) {
+    if (attempts) {
+        *attempts = atomic_load_explicit(&job->attempts, memory_order_relaxed);
+    }
+    return (nip13_status_t)atomic_load(&job->status);
+}
+
+int nip13_job_best(const nip13_job_t* job) {
+    return atomic_load_explicit(&job->best_zeros, memory_order_relaxed);
+}
+
+void nip13_job_cancel(nip13_job_t* job) {
+    atomic_store(&job->cancelled, 1);
+}
+
+// Split a job nonce into the created_at and nonce it stands for
+static void fill_proof(const nip13_job_t* job, uint64_t job_nonce, const uint8_t* hash, nip13_proof_t* proof) {
+    if (job->roll.tmpls) {
+        proof->created_at = job->roll.first_timestamp + job_nonce / NIP13_ROLL_NONCES;
+        proof->nonce = job_nonce % NIP13_ROLL_NONCES;
+    } else {
+        proof->created_at = job->created_at;
+        proof->nonce = job_nonce;
+    }
+    memcpy(proof->hash, hash, SHA256_DIGEST_SIZE);
+    proof->zeros = count_leading_zeros(hash);
+    proof->worker = -1;
+}
+
+int nip13_job_result(const nip13_job_t* job, nip13_proof_t* proof) {
+    int winner = atomic_load(&job->winner);
+    if (winner >= 0 || (job->keep_best && atomic_load(&job->best_zeros) > 0)) {
+        fill_proof(job, job->found_nonce, job->found_hash, proof);
+        proof->worker = winner;
+        return 1;
+    }
+
+    // Fall back to the highest tier reached on the way
+    return job->tiers_reached > 0 && nip13_job_tier(job, job->tiers_reached - 1, proof);
+}
+
+int nip13_job_tier(const nip13_job_t* job, int tier, nip13_proof_t* proof) {
+    nip13_pool_t* pool = job->pool;
+    pthread_mutex_lock(&pool->lock);
+    int reached = tier >= 0 && tier < job->tiers_reached;
+    pthread_mutex_unlock(&pool->lock);
+    if (reached) {
+        fill_proof(job, job->tier_nonce[tier], job->tier_hash[tier], proof);
+    }
+    return reached;
+}
+
+char* nip13_job_event_json(const nip13_job_t* job, const nip13_proof_t* proof) {
+    if (!job->roll.tmpls) {
+        return nip13_template_event_json(&job->tmpl, job->event_json, proof->nonce);
+    }
+
+    uint64_t index = proof->created_at - job->roll.first_timestamp;
+    const nip13_template_t* tmpl = index < job->roll.timestamps ? atomic_load(&job->roll.tmpls[index]) : NULL;
+    char* json = tmpl ? set_created_at_in_json(job->event_json, proof->created_at) : NULL;
+    char* result = json ? nip13_template_event_json(tmpl, json, proof->nonce) : NULL;
+    free(json);
+    return result;
+}
+
+const nip13_layout_t* nip13_job_layout(const nip13_job_t* job) {
+    return &job->first->layout;
+}
+
+uint64_t nip13_job_timestamps(const nip13_job_t* job) {
+    if (!job->roll.tmpls) {
+        return 1;
+    }
+    uint64_t used = 0;
+    for (uint64_t i = 0; i < job->roll.timestamps; i++) {
+        used += atomic_load(&job->roll.tmpls[i]) != NULL;
+    }
+    return used;
+}
+
+void nip13_job_free(nip13_job_t* job) {
+    if (!job) {
+        return;
+    }
+    // Called from on_done: the worker running it releases the job afterwards
+    if (job->in_on_done) {
+        job->free_deferred = 1;
+        return;
+    }
+    job_release(job);
+}
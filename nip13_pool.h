@@ -0,0 +1,157 @@
+/*
+ * Reentrant NIP-13 mining library (libnip13)
+ * A pool of worker threads mines any number of jobs at once. All mining
+ * state lives in the pool and job objects and nothing is printed, so
+ * several pools and concurrent jobs can share one process.
+ */
+
+#ifndef NIP13_POOL_H
+#define NIP13_POOL_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "nip13_engine.h"
+#include "cpu_topology.h"
+
+#define NIP13_MAX_TIERS 8
+
+// Nonces tried under each created_at when rolling: 10-digit slots, exhausted
+// within a second only above 1 GH/s, so the clock rather than exhaustion
+// moves the search to the next timestamp
+#define NIP13_ROLL_NONCES 1000000000ULL
+#define NIP13_ROLL_MAX_WINDOW (30ULL * 24 * 3600)
+
+typedef struct nip13_pool nip13_pool_t;
+typedef struct nip13_job nip13_job_t;
+
+typedef enum {
+    NIP13_JOB_PENDING,              // Created, not started
+    NIP13_JOB_RUNNING,              // Queued or being mined
+    NIP13_JOB_FOUND,                // Reached the difficulty
+    NIP13_JOB_EXHAUSTED,            // Searched the whole range (or roll window) without reaching it
+    NIP13_JOB_EXPIRED,              // Stopped by the deadline
+    NIP13_JOB_CANCELLED,            // Stopped by nip13_job_cancel or nip13_pool_destroy
+    NIP13_JOB_FAILED,               // Stopped early: a worker could not allocate its lanes or a template
+} nip13_status_t;
+
+// Job callbacks run on a worker thread with no library lock held
+typedef void (*nip13_job_fn)(nip13_job_t* job, void* user);
+typedef void (*nip13_tier_fn)(nip13_job_t* job, int tier, void* user);
+
+typedef struct {
+    int difficulty;                 // Leading zero bits to reach (1-64)
+    uint64_t start_nonce;           // Nonces tried are [start_nonce, end_nonce)
+    uint64_t end_nonce;             // Also sizes the nonce slot; ignored when rolling
+    uint64_t deadline_us;           // nip13_time_us() at which to stop, 0 for none
+    int keep_best;                  // Keep the best proof seen; difficulty only ends the search early
+    int track_best;                 // Also track the best zeros below the difficulty for nip13_job_best
+    const int* tiers;               // Ascending difficulties ending at difficulty, reported as first reached
+    int tier_count;                 // Up to NIP13_MAX_TIERS (copied at create)
+    uint64_t roll_window;           // Also roll created_at forward across this many seconds, 0 to keep it
+    uint64_t roll_start;            // First created_at of the roll, 0 for now
+    nip13_job_fn on_found;          // Winning worker, right after the result is published
+    nip13_job_fn on_done;           // Last worker to leave the finished job, before nip13_job_wait returns; the job may be freed here
+    nip13_tier_fn on_tier;          // Worker that first reaches tiers[tier]
+    void* user;                     // Passed to every callback
+} nip13_job_params_t;
+
+// Hardware events counted by the workers around the jobs they mine
+#define NIP13_COUNTER_CYCLES (1u << 0)
+#define NIP13_COUNTER_INSTRUCTIONS (1u << 1)
+#define NIP13_COUNTER_CACHE_MISSES (1u << 2)
+#define NIP13_COUNTER_BRANCH_MISSES (1u << 3)
+
+typedef struct {
+    uint64_t cycles;                // User space only
+    uint64_t instructions;
+    uint64_t cache_misses;          // Last-level cache misses
+    uint64_t branch_misses;
+    uint64_t time_ns;               // CPU time of the counted workers
+    unsigned valid;                 // NIP13_COUNTER_* events every worker could count
+} nip13_counters_t;
+
+typedef struct {
+    uint64_t nonce;                 // Value of the nonce tag
+    uint64_t created_at;            // created_at it was mined under
+    uint8_t hash[SHA256_DIGEST_SIZE];
+    int zeros;
+    int worker;                     // Worker that reached the difficulty, -1 for best-so-far or tier results
+} nip13_proof_t;
+
+// Spawn the workers once; they stay parked until a job is started.
+// topology (kept by the pool) pins them in placement order when set.
+nip13_pool_t* nip13_pool_create(int threads, const cpu_topology_t* topology);
+
+// Cancel every open job (on_done still runs for each) and join the workers
+void nip13_pool_destroy(nip13_pool_t* pool);
+
+int nip13_pool_threads(const nip13_pool_t* pool);
+
+// Lifetime attempts of each worker, flushed once per chunk, for progress
+// reporters; fills up to count entries and returns the number of workers
+int nip13_pool_attempts(const nip13_pool_t* pool, uint64_t* attempts, int count);
+
+// Record a timeline per worker: job start, chunk claims with their duration,
+// the solution, the moment a worker notices the job stopped, and job exit.
+// Each worker keeps its last events_per_thread events (rounded up to a power
+// of two) in its own ring, so recording costs no lock. Call before starting
+// jobs; returns 0 when the rings cannot be allocated.
+int nip13_pool_enable_trace(nip13_pool_t* pool, int events_per_thread);
+
+// Write the timelines as Chrome trace-event JSON (chrome://tracing, Perfetto),
+// times relative to nip13_pool_enable_trace. Call while no job is running;
+// returns 0 on a write error.
+int nip13_pool_write_trace(nip13_pool_t* pool, FILE* out);
+
+// Count cycles, instructions, cache and branch misses in every worker around
+// each job it mines (Linux perf_event_open). Returns 0 with errno set when
+// this process cannot open counters, as in most containers; the pool then
+// keeps mining uncounted. Totals restart at each call.
+int nip13_pool_enable_counters(nip13_pool_t* pool);
+
+// Totals since counters were enabled, which snapshots subtract to cover a
+// run. Returns 0 while nothing was counted or when a worker could not count.
+int nip13_pool_counters(nip13_pool_t* pool, nip13_counters_t* counters);
+
+// Serialize the event into a job; NULL for malformed events or parameters
+nip13_job_t* nip13_job_create(nip13_pool_t* pool, const char* event_json, const nip13_job_params_t* params);
+
+// Queue the job on its pool and return at once (a job runs only once)
+void nip13_job_start(nip13_job_t* job);
+
+// Block until every worker has left the job and on_done has returned
+// (a job freed by its on_done must not be waited on)
+nip13_status_t nip13_job_wait(nip13_job_t* job);
+
+// Current status; attempts (optional) receives the attempts so far
+nip13_status_t nip13_job_poll(const nip13_job_t* job, uint64_t* attempts);
+
+// Most leading zeros seen so far: the best proof (keep_best), the best hash
+// (track_best) or the highest tier hash; 0 for jobs that track none of them
+int nip13_job_best(const nip13_job_t* job);
+
+// Stop at the next chunk boundary (about 2 ms); the job finishes as cancelled
+void nip13_job_cancel(nip13_job_t* job);
+
+// Proof of a finished job: the winning one, else the best kept (keep_best)
+// or the highest tier reached. Returns 0 when there is none.
+int nip13_job_result(const nip13_job_t* job, nip13_proof_t* proof);
+
+// First proof of tiers[tier]; returns 0 while the tier is not reached
+int nip13_job_tier(const nip13_job_t* job, int tier, nip13_proof_t* proof);
+
+// Event JSON carrying the proof's created_at and nonce (caller frees)
+char* nip13_job_event_json(const nip13_job_t* job, const nip13_proof_t* proof);
+
+// Nonce layout of the job (of its first timestamp when rolling)
+const nip13_layout_t* nip13_job_layout(const nip13_job_t* job);
+
+// Timestamps templated so far (1 unless rolling)
+uint64_t nip13_job_timestamps(const nip13_job_t* job);
+
+// Free a job that has finished or was never started; from its own on_done
+// the job is released once the callback returns
+void nip13_job_free(nip13_job_t* job);
+
+#endif
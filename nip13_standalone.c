@@ -13,480 +13,126 @@
 #include <sys/time.h>
 #include <math.h>
 
-// Simplified SHA256 constants and functions based on hashcat
-#define SHA256_DIGEST_SIZE 32
-#define SHA256_BLOCK_SIZE  64
-
-// SHA256 constants (from hashcat)
-static const uint32_t sha256_k[64] = {
-    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
-    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
-    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
-    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
-    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
-    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
-    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
-    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
-};
-
-// Rotate right
-#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
-
-// SHA256 functions (optimized versions from hashcat)
-#define CH(x, y, z)  (((x) & (y)) ^ (~(x) & (z)))
-#define MAJ(x, y, z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
-#define S0(x)        (ROTR(x,  2) ^ ROTR(x, 13) ^ ROTR(x, 22))
-#define S1(x)        (ROTR(x,  6) ^ ROTR(x, 11) ^ ROTR(x, 25))
-#define s0(x)        (ROTR(x,  7) ^ ROTR(x, 18) ^ ((x) >>  3))
-#define s1(x)        (ROTR(x, 17) ^ ROTR(x, 19) ^ ((x) >> 10))
-
-// SHA256 context
-typedef struct {
-    uint32_t state[8];
-    uint64_t count;
-    uint8_t buffer[64];
-} sha256_ctx_t;
-
-// Initialize SHA256 context
-void sha256_init(sha256_ctx_t *ctx) {
-    ctx->state[0] = 0x6a09e667;
-    ctx->state[1] = 0xbb67ae85;
-    ctx->state[2] = 0x3c6ef372;
-    ctx->state[3] = 0xa54ff53a;
-    ctx->state[4] = 0x510e527f;
-    ctx->state[5] = 0x9b05688c;
-    ctx->state[6] = 0x1f83d9ab;
-    ctx->state[7] = 0x5be0cd19;
-    ctx->count = 0;
-}
-
-// Process a single 512-bit block (optimized from hashcat)
-void sha256_transform(sha256_ctx_t *ctx, const uint8_t *data) {
-    uint32_t w[64];
-    uint32_t a, b, c, d, e, f, g, h;
-    uint32_t t1, t2;
-
-    // Prepare message schedule
-    for (int i = 0; i < 16; i++) {
-        w[i] = (data[i * 4] << 24) | (data[i * 4 + 1] << 16) |
-               (data[i * 4 + 2] << 8) | data[i * 4 + 3];
-    }
-
-    for (int i = 16; i < 64; i++) {
-        w[i] = s1(w[i - 2]) + w[i - 7] + s0(w[i - 15]) + w[i - 16];
-    }
-
-    // Initialize working variables
-    a = ctx->state[0];
-    b = ctx->state[1];
-    c = ctx->state[2];
-    d = ctx->state[3];
-    e = ctx->state[4];
-    f = ctx->state[5];
-    g = ctx->state[6];
-    h = ctx->state[7];
-
-    // Main loop (unrolled for performance like hashcat)
-    for (int i = 0; i < 64; i++) {
-        t1 = h + S1(e) + CH(e, f, g) + sha256_k[i] + w[i];
-        t2 = S0(a) + MAJ(a, b, c);
-        h = g;
-        g = f;
-        f = e;
-        e = d + t1;
-        d = c;
-        c = b;
-        b = a;
-        a = t1 + t2;
-    }
-
-    // Add compressed chunk to current hash value
-    ctx->state[0] += a;
-    ctx->state[1] += b;
-    ctx->state[2] += c;
-    ctx->state[3] += d;
-    ctx->state[4] += e;
-    ctx->state[5] += f;
-    ctx->state[6] += g;
-    ctx->state[7] += h;
-}
-
-// Update SHA256 with new data
-void sha256_update(sha256_ctx_t *ctx, const uint8_t *data, size_t len) {
-    size_t buffer_space = 64 - (ctx->count % 64);
-
-    ctx->count += len;
-
-    if (len >= buffer_space) {
-        memcpy(ctx->buffer + (64 - buffer_space), data, buffer_space);
-        sha256_transform(ctx, ctx->buffer);
-        data += buffer_space;
-        len -= buffer_space;
-
-        while (len >= 64) {
-            sha256_transform(ctx, data);
-            data += 64;
-            len -= 64;
-        }
-    }
-
-    if (len > 0) {
-        memcpy(ctx->buffer + (ctx->count % 64) - len, data, len);
-    }
-}
-
-// Finalize SHA256 and output digest
-void sha256_final(sha256_ctx_t *ctx, uint8_t *digest) {
-    uint64_t bit_count = ctx->count * 8;
-    size_t pad_len = (ctx->count % 64 < 56) ? (56 - ctx->count % 64) : (120 - ctx->count % 64);
-
-    uint8_t padding[64] = {0x80};
-    sha256_update(ctx, padding, pad_len);
-
-    // Append length in bits as big-endian 64-bit integer
-    uint8_t len_bytes[8];
-    for (int i = 7; i >= 0; i--) {
-        len_bytes[i] = bit_count & 0xff;
-        bit_count >>= 8;
-    }
-    sha256_update(ctx, len_bytes, 8);
-
-    // Output final hash
-    for (int i = 0; i < 8; i++) {
-        digest[i * 4] = (ctx->state[i] >> 24) & 0xff;
-        digest[i * 4 + 1] = (ctx->state[i] >> 16) & 0xff;
-        digest[i * 4 + 2] = (ctx->state[i] >> 8) & 0xff;
-        digest[i * 4 + 3] = ctx->state[i] & 0xff;
-    }
-}
-
-// Complete SHA256 hash in one call
-void sha256_hash(const uint8_t *data, size_t len, uint8_t *digest) {
-    sha256_ctx_t ctx;
-    sha256_init(&ctx);
-    sha256_update(&ctx, data, len);
-    sha256_final(&ctx, digest);
-}
-
-// Count leading zero bits in hash
-int count_leading_zeros(const uint8_t *hash) {
-    int zeros = 0;
-    for (int i = 0; i < SHA256_DIGEST_SIZE; i++) {
-        if (hash[i] == 0) {
-            zeros += 8;
-        } else {
-            uint8_t byte = hash[i];
-            while ((byte & 0x80) == 0) {
-                zeros++;
-                byte <<= 1;
-            }
-            break;
-        }
-    }
-    return zeros;
-}
-
-// Convert hash to hex string
-void hash_to_hex(const uint8_t *hash, char *hex_str) {
-    for (int i = 0; i < SHA256_DIGEST_SIZE; i++) {
-        sprintf(hex_str + i * 2, "%02x", hash[i]);
-    }
-    hex_str[64] = '\0';
-}
-
-// Get current time in microseconds
-uint64_t get_time_us() {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    return tv.tv_sec * 1000000ULL + tv.tv_usec;
-}
-
-// Extract field value from JSON
-char* extract_json_field(const char* json, const char* field) {
-    char* field_pattern = malloc(strlen(field) + 10);
-    sprintf(field_pattern, "\"%s\":", field);
-
-    char* field_pos = strstr(json, field_pattern);
-    if (!field_pos) {
-        free(field_pattern);
-        return NULL;
-    }
-
-    char* value_start = strchr(field_pos, ':') + 1;
-    while (*value_start == ' ' || *value_start == '\t') value_start++;
-
-    char* value_end;
-    int len;
-
-    if (*value_start == '"') {
-        // String value
-        value_start++; // Skip opening quote
-        value_end = strchr(value_start, '"');
-        len = value_end - value_start;
-    } else if (*value_start == '[') {
-        // Array value - find matching bracket
-        int bracket_count = 0;
-        value_end = value_start;
-        do {
-            if (*value_end == '[') bracket_count++;
-            if (*value_end == ']') bracket_count--;
-            value_end++;
-        } while (bracket_count > 0 && *value_end);
-        len = value_end - value_start;
-    } else {
-        // Number value
-        value_end = value_start;
-        while (*value_end && *value_end != ',' && *value_end != '}' && *value_end != ']') {
-            value_end++;
-        }
-        len = value_end - value_start;
-    }
-
-    char* result = malloc(len + 1);
-    strncpy(result, value_start, len);
-    result[len] = '\0';
-
-    free(field_pattern);
-    return result;
-}
-
-// Calculate Nostr event ID using canonical representation
-void calculate_nostr_event_id(const char* json, uint8_t* id_hash) {
-    // Extract fields for canonical representation
-    char* pubkey = extract_json_field(json, "pubkey");
-    char* created_at = extract_json_field(json, "created_at");
-    char* kind = extract_json_field(json, "kind");
-    char* tags = extract_json_field(json, "tags");
-    char* content = extract_json_field(json, "content");
-
-    // Build canonical array: [0, pubkey, created_at, kind, tags, content]
-    char* canonical = malloc(strlen(pubkey) + strlen(created_at) + strlen(kind) +
-                            strlen(tags) + strlen(content) + 100);
-
-    sprintf(canonical, "[0,\"%s\",%s,%s,%s,\"%s\"]",
-            pubkey, created_at, kind, tags, content);
-
-    // Calculate SHA256 hash
-    sha256_hash((uint8_t*)canonical, strlen(canonical), id_hash);
-
-    // Cleanup
-    free(pubkey);
-    free(created_at);
-    free(kind);
-    free(tags);
-    free(content);
-    free(canonical);
-}
-
-// Simple JSON manipulation (find and replace nonce)
-char* update_nonce_in_json(const char* json, uint64_t nonce) {
-    // Find existing nonce or create new one
-    char* result = malloc(strlen(json) + 100); // Extra space for nonce
-    char nonce_str[32];
-    sprintf(nonce_str, "\"%llu\"", (unsigned long long)nonce);
-
-    // Look for existing nonce tag
-    char* nonce_pos = strstr(json, "\"nonce\"");
-    if (nonce_pos) {
-        // Find the value after "nonce":
-        char* value_start = strchr(nonce_pos, ':');
-        if (value_start) {
-            value_start++;
-            while (*value_start == ' ' || *value_start == '\t') value_start++;
-
-            char* value_end = value_start;
-            if (*value_start == '"') {
-                value_end = strchr(value_start + 1, '"') + 1;
-            } else {
-                while (*value_end && *value_end != ',' && *value_end != ']' && *value_end != '}') {
-                    value_end++;
-                }
-            }
-
-            // Replace the nonce value
-            strncpy(result, json, value_start - json);
-            result[value_start - json] = '\0';
-            strcat(result, nonce_str);
-            strcat(result, value_end);
-        }
-    } else {
-        // Add nonce to tags array
-        char* tags_pos = strstr(json, "\"tags\"");
-        if (tags_pos) {
-            char* array_start = strchr(tags_pos, '[');
-            if (array_start) {
-                strncpy(result, json, array_start - json + 1);
-                result[array_start - json + 1] = '\0';
-
-                // Add nonce tag
-                strcat(result, "[\"nonce\",");
-                strcat(result, nonce_str);
-                strcat(result, "]");
-
-                // Add rest of tags
-                char* rest = array_start + 1;
-                while (*rest == ' ' || *rest == '\t' || *rest == '\n') rest++;
-                if (*rest != ']') {
-                    strcat(result, ",");
-                    strcat(result, rest);
-                } else {
-                    strcat(result, rest);
-                }
-            }
-        }
-    }
-
-    return result;
-}
-
-// Set the event ID and clear signature
-char* set_event_id_and_clear_sig(const char* json, const char* id_hex) {
-    char* temp_result = malloc(strlen(json) + 100);
-
-    // First, set the event ID
-    char* id_pos = strstr(json, "\"id\":");
-    if (id_pos) {
-        // Find the value after "id":
-        char* value_start = strchr(id_pos, ':');
-        if (value_start) {
-            value_start++;
-            while (*value_start == ' ' || *value_start == '\t') value_start++;
-
-            char* value_end = value_start;
-            if (*value_start == '"') {
-                value_end = strchr(value_start + 1, '"') + 1;
-            } else {
-                while (*value_end && *value_end != ',' && *value_end != ']' && *value_end != '}') {
-                    value_end++;
-                }
-            }
-
-            // Replace the id value
-            strncpy(temp_result, json, value_start - json);
-            temp_result[value_start - json] = '\0';
-            strcat(temp_result, "\"");
-            strcat(temp_result, id_hex);
-            strcat(temp_result, "\"");
-            strcat(temp_result, value_end);
-        }
-    } else {
-        // If no id field found, just copy the original
-        strcpy(temp_result, json);
-    }
-
-    // Now clear the signature
-    char* result = malloc(strlen(temp_result) + 100);
-    char* sig_pos = strstr(temp_result, "\"sig\":");
-    if (sig_pos) {
-        // Find the value after "sig":
-        char* value_start = strchr(sig_pos, ':');
-        if (value_start) {
-            value_start++;
-            while (*value_start == ' ' || *value_start == '\t') value_start++;
-
-            char* value_end = value_start;
-            if (*value_start == '"') {
-                value_end = strchr(value_start + 1, '"') + 1;
-            }
-
-            // Replace with empty signature
-            strncpy(result, temp_result, value_start - temp_result);
-            result[value_start - temp_result] = '\0';
-            strcat(result, "\"\"");
-            strcat(result, value_end);
-        }
-    } else {
-        strcpy(result, temp_result);
-    }
-
-    free(temp_result);
-    return result;
-}
+#include "sha256.h"
+#include "nostr_event.h"
+#include "nip13_engine.h"
 
 // NIP-13 Proof of Work miner with range support
-int nip13_mine_range(const char* event_json, int difficulty, uint64_t start_nonce,
+int nip13_mine_range(const nip13_template_t* tmpl, int difficulty, uint64_t start_nonce,
                     uint64_t end_nonce, uint64_t* found_nonce, uint64_t* attempts) {
-    uint64_t nonce = start_nonce;
-    uint8_t hash[SHA256_DIGEST_SIZE];
+    nip13_batch_t batch;
     *attempts = 0;
 
-    while (nonce < end_nonce) {
-        // Update nonce in JSON
-        char* event_with_nonce = update_nonce_in_json(event_json, nonce);
-
-        // Calculate the Nostr event ID (canonical representation hash)
-        calculate_nostr_event_id(event_with_nonce, hash);
-        (*attempts)++;
-
-        // Check if we found a valid proof
-        int leading_zeros = count_leading_zeros(hash);
-        if (leading_zeros >= difficulty) {
-            *found_nonce = nonce;
-            free(event_with_nonce);
+    if (!nip13_batch_init(&batch, tmpl, 0)) {
+        return 0;
+    }
+    nip13_batch_seek(&batch, start_nonce);
+
+    while (nip13_batch_nonce(&batch) < end_nonce) {
+        // Calculate the Nostr event IDs for every SIMD lane
+        uint32_t hits;
+        int scanned = nip13_batch_scan(&batch, difficulty, end_nonce, &hits);
+        *attempts += scanned;
+
+        // Check if we found a valid proof (lowest lane is the lowest nonce);
+        // the last scan of a range may have fewer active lanes than the batch
+        if (hits) {
+            int lane = __builtin_ctz(hits);
+            *found_nonce = nip13_batch_nonce(&batch) + lane;
+            *attempts -= scanned - 1 - lane;
+            nip13_batch_free(&batch);
             return 1;
         }
 
-        free(event_with_nonce);
-        nonce++;
+        nip13_batch_next(&batch);
     }
 
+    nip13_batch_free(&batch);
     return 0; // Not found in range
 }
 
 // NIP-13 Proof of Work miner with hash output
-int nip13_mine_with_hash(const char* event_json, int difficulty, uint64_t max_iterations, uint64_t* found_nonce, uint8_t* final_hash, int quiet) {
+int nip13_mine_with_hash(const nip13_template_t* tmpl, int difficulty, uint64_t max_iterations, uint64_t* found_nonce, uint8_t* final_hash, int quiet) {
     if (!quiet) {
         fprintf(stderr, "🔨 Starting NIP-13 mining (difficulty: %d bits)\n", difficulty);
-        fprintf(stderr, "📝 Event: %.60s%s\n", event_json, strlen(event_json) > 60 ? "..." : "");
+        fprintf(stderr, "📝 Event: %.60s%s\n", tmpl->canonical, tmpl->canonical_len > 60 ? "..." : "");
     }
 
-    uint64_t nonce = 0;
-    uint64_t start_time = get_time_us();
+    uint64_t start_time = nip13_time_us();
     uint64_t last_report = start_time;
+    uint64_t next_report = 1000000;
     uint8_t hash[SHA256_DIGEST_SIZE];
     char hash_hex[65];
+    nip13_batch_t batch;
+    int best = 0;
 
-    while (nonce < max_iterations) {
-        // Update nonce in JSON
-        char* event_with_nonce = update_nonce_in_json(event_json, nonce);
+    if (!nip13_batch_init(&batch, tmpl, 0)) {
+        return 0;
+    }
 
-        // Calculate the Nostr event ID (canonical representation hash)
-        calculate_nostr_event_id(event_with_nonce, hash);
+    while (nip13_batch_nonce(&batch) < max_iterations) {
+        // Calculate the Nostr event IDs for every SIMD lane. With progress
+        // reports the bar sits just above the best so far, which rises
+        // about once per doubling of attempts, so tracking it is nearly free.
+        uint32_t hits;
+        int threshold = quiet || best + 1 >= difficulty ? difficulty : best + 1;
+        nip13_batch_scan(&batch, threshold, max_iterations, &hits);
+
+        if (hits && threshold < difficulty) {
+            uint32_t solved = 0;
+            for (uint32_t mask = hits; mask; mask &= mask - 1) {
+                int zeros = nip13_batch_lane_zeros(&batch, __builtin_ctz(mask));
+                if (zeros >= difficulty) {
+                    solved |= mask & -mask;
+                }
+                if (zeros > best) {
+                    best = zeros;
+                }
+            }
+            hits = solved;
+        }
 
         // Check if we found a valid proof
-        int leading_zeros = count_leading_zeros(hash);
-        if (leading_zeros >= difficulty) {
+        if (hits) {
+            int lane = __builtin_ctz(hits);
+            uint64_t nonce = nip13_batch_nonce(&batch) + lane;
+
+            // Only the winning lane gets its full digest
+            nip13_cursor_hash(&batch.cursors[lane], hash);
+
             if (!quiet) {
                 hash_to_hex(hash, hash_hex);
                 fprintf(stderr, "✅ Found valid proof!\n");
                 fprintf(stderr, "🎯 Nonce: %llu\n", (unsigned long long)nonce);
                 fprintf(stderr, "🔒 Hash:  %s\n", hash_hex);
-                fprintf(stderr, "⚡ Leading zeros: %d\n", leading_zeros);
+                fprintf(stderr, "⚡ Leading zeros: %d\n", count_leading_zeros(hash));
 
-                uint64_t elapsed = get_time_us() - start_time;
+                uint64_t elapsed = nip13_time_us() - start_time;
                 fprintf(stderr, "⏱️  Time: %.2f seconds\n", elapsed / 1000000.0);
-                fprintf(stderr, "🚀 Rate: %.2f MH/s\n", (nonce / 1000000.0) / (elapsed / 1000000.0));
+                fprintf(stderr, "🚀 Rate: %.2f MH/s (%s)\n", (nonce / 1000000.0) / (elapsed / 1000000.0),
+                        sha256_multi_name(batch.lanes));
             }
 
             *found_nonce = nonce;
             memcpy(final_hash, hash, SHA256_DIGEST_SIZE);
-            free(event_with_nonce);
+            nip13_batch_free(&batch);
             return 1;
         }
 
-        free(event_with_nonce);
-        nonce++;
+        nip13_batch_next(&batch);
 
         // Progress report every 1M iterations
-        if (!quiet && nonce % 1000000 == 0) {
-            uint64_t now = get_time_us();
+        if (!quiet && nip13_batch_nonce(&batch) >= next_report) {
+            uint64_t now = nip13_time_us();
             double rate = 1000000.0 / ((now - last_report) / 1000000.0);
             fprintf(stderr, "⚡ %llu M attempts, %.2f MH/s, best: %d zeros\n",
-                   (unsigned long long)(nonce / 1000000), rate / 1000000.0, leading_zeros);
+                   (unsigned long long)(next_report / 1000000), rate / 1000000.0, best);
             last_report = now;
+            next_report += 1000000;
         }
     }
 
+    nip13_batch_free(&batch);
     if (!quiet) {
         fprintf(stderr, "❌ No valid proof found after %llu attempts\n", (unsigned long long)max_iterations);
     }
@@ -494,9 +140,9 @@ int nip13_mine_with_hash(const char* event_json, int difficulty, uint64_t max_it
 }
 
 // NIP-13 Proof of Work miner
-int nip13_mine(const char* event_json, int difficulty, uint64_t max_iterations, uint64_t* found_nonce, int quiet) {
+int nip13_mine(const nip13_template_t* tmpl, int difficulty, uint64_t max_iterations, uint64_t* found_nonce, int quiet) {
     uint8_t hash[SHA256_DIGEST_SIZE];
-    return nip13_mine_with_hash(event_json, difficulty, max_iterations, found_nonce, hash, quiet);
+    return nip13_mine_with_hash(tmpl, difficulty, max_iterations, found_nonce, hash, quiet);
 }
 
 
@@ -512,12 +158,19 @@ int benchmark_mode(char* event_json, int difficulty, int target_solutions) {
     uint64_t total_attempts = 0;
     uint64_t starting_nonce = 1;
 
+    // One template covers every range the benchmark may search
+    nip13_template_t tmpl;
+    if (!nip13_template_init(&tmpl, event_json, 1000000000000ULL + 100000000ULL, difficulty)) {
+        printf("❌ Error: Malformed event JSON\n");
+        return 0;
+    }
+
     while (solutions_found < target_solutions) {
         uint64_t found_nonce;
         uint64_t attempts_this_round = 0;
 
         // Mine starting from the last found nonce + 1000 to avoid duplicates
-        if (nip13_mine_range(event_json, difficulty, starting_nonce,
+        if (nip13_mine_range(&tmpl, difficulty, starting_nonce,
                             starting_nonce + 100000000ULL, &found_nonce, &attempts_this_round)) {
             solutions_found++;
             total_attempts += attempts_this_round;
@@ -528,11 +181,14 @@ int benchmark_mode(char* event_json, int difficulty, int target_solutions) {
             starting_nonce += 100000000ULL;
             if (starting_nonce > 1000000000000ULL) { // Prevent infinite loop
                 printf("💔 Benchmark failed - difficulty may be too high\n");
+                nip13_template_free(&tmpl);
                 return 0;
             }
         }
     }
 
+    nip13_template_free(&tmpl);
+
     // Final statistics
     gettimeofday(&current_time, NULL);
     double total_elapsed = (current_time.tv_sec - start_time.tv_sec) +
@@ -555,10 +211,20 @@ int benchmark_mode(char* event_json, int difficulty, int target_solutions) {
 
 // Main function
 int main(int argc, char* argv[]) {
+    // Verbose mode: mining progress and nonce layout on stderr
+    int verbose = 0;
+    if (argc > 1 && (strcmp(argv[1], "-v") == 0 || strcmp(argv[1], "--verbose") == 0)) {
+        verbose = 1;
+        argv[1] = argv[0];
+        argv++;
+        argc--;
+    }
+
     // Show usage if help is requested
     if (argc > 1 && (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0)) {
-        printf("Usage: %s [difficulty] [max_attempts|benchmark]\n", argv[0]);
+        printf("Usage: %s [-v] [difficulty] [max_attempts|benchmark]\n", argv[0]);
         printf("  Reads Nostr event JSON from stdin\n");
+        printf("  -v           - Verbose: progress, nonce layout and blocks per attempt on stderr\n");
         printf("  difficulty   - Target difficulty in bits (default: 16)\n");
         printf("  max_attempts - Maximum attempts in millions (default: 100)\n");
         printf("  benchmark N  - Benchmark mode: find N solutions and measure solutions/sec\n\n");
@@ -633,12 +299,24 @@ int main(int argc, char* argv[]) {
         free(event_json);
         return (solutions_found == target_solutions) ? 0 : 1;
     } else {
+        // Serialize the canonical event once for the whole search
+        nip13_template_t tmpl;
+        if (!nip13_template_init(&tmpl, event_json, max_attempts, difficulty)) {
+            fprintf(stderr, "❌ Error: Malformed event JSON\n");
+            free(event_json);
+            return 1;
+        }
+
+        if (verbose) {
+            nip13_print_layout(stderr, &tmpl.layout);
+        }
+
         // Start regular mining
         uint64_t found_nonce;
         uint8_t final_hash[SHA256_DIGEST_SIZE];
-        if (nip13_mine_with_hash(event_json, difficulty, max_attempts, &found_nonce, final_hash, 1)) {
-            // First add the nonce to the event
-            char* event_with_nonce = update_nonce_in_json(event_json, found_nonce);
+        if (nip13_mine_with_hash(&tmpl, difficulty, max_attempts, &found_nonce, final_hash, !verbose)) {
+            // First add the nonce to the event, exactly as it was hashed
+            char* event_with_nonce = nip13_template_event_json(&tmpl, event_json, found_nonce);
 
             // Convert the mining hash to hex - this is the event ID
             char id_hex[65];
@@ -652,9 +330,11 @@ int main(int argc, char* argv[]) {
 
             free(final_event);
             free(event_json);
+            nip13_template_free(&tmpl);
             return 0;
         } else {
             free(event_json);
+            nip13_template_free(&tmpl);
             return 1;
         }
     }
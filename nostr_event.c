@@ -0,0 +1,827 @@
+/*
+ * Nostr event JSON helpers shared by the NIP-13 miners
+ * A single-pass tokenizer records where each field and tag lives; every
+ * rewrite and the canonical serialization work from those spans. No JSON
+ * library required.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nostr_event.h"
+#include "sha256.h"
+
+static const char* skip_ws(const char* p) {
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') p++;
+    return p;
+}
+
+// One past the closing quote of the string at p (NULL if unterminated)
+static const char* skip_string(const char* p) {
+    for (p++; *p != '"'; p++) {
+        if (!*p || (*p == '\\' && !*++p)) {
+            return NULL;
+        }
+    }
+    return p + 1;
+}
+
+// One past the JSON value at p (NULL if malformed)
+static const char* skip_value(const char* p) {
+    if (*p == '"') {
+        return skip_string(p);
+    }
+    if (*p == '[' || *p == '{') {
+        int depth = 0;
+        do {
+            if (*p == '"') {
+                if (!(p = skip_string(p))) return NULL;
+                continue;
+            }
+            if (*p == '[' || *p == '{') depth++;
+            if (*p == ']' || *p == '}') depth--;
+            if (!*p) return NULL;
+            p++;
+        } while (depth > 0);
+        return p;
+    }
+
+    // Number or literal
+    const char* start = p;
+    while (*p && *p != ',' && *p != '}' && *p != ']' && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r') {
+        p++;
+    }
+    return p > start ? p : NULL;
+}
+
+// Value of the member at p ("name": value) and its name (NULL if malformed)
+static const char* member_value(const char* p, const char** name, size_t* name_len) {
+    if (*p != '"') {
+        return NULL;
+    }
+    const char* name_end = skip_string(p);
+    if (!name_end) {
+        return NULL;
+    }
+    *name = p + 1;
+    *name_len = name_end - 1 - *name;
+
+    p = skip_ws(name_end);
+    return *p == ':' ? skip_ws(p + 1) : NULL;
+}
+
+// Value of a top-level member of a JSON object
+const char* json_object_member(const char* json, const char* key, const char** value_end) {
+    size_t key_len = strlen(key);
+    const char* p = skip_ws(json);
+    if (*p++ != '{') {
+        return NULL;
+    }
+
+    p = skip_ws(p);
+    while (*p == '"') {
+        const char* name;
+        size_t name_len;
+        const char* value = member_value(p, &name, &name_len);
+        const char* end = value ? skip_value(value) : NULL;
+        if (!end) {
+            return NULL;
+        }
+        if (name_len == key_len && memcmp(name, key, key_len) == 0) {
+            if (value_end) {
+                *value_end = end;
+            }
+            return value;
+        }
+
+        p = skip_ws(end);
+        if (*p != ',') {
+            return NULL;
+        }
+        p = skip_ws(p + 1);
+    }
+    return NULL;
+}
+
+static json_span_t make_span(const char* json, const char* start, const char* end) {
+    json_span_t span = { (size_t)(start - json), (size_t)(end - start) };
+    return span;
+}
+
+// Copy of json with count spans (ascending, non-overlapping) replaced by texts
+static char* splice_spans(const char* json, const json_span_t* spans, const char* const* texts, int count) {
+    size_t len = strlen(json);
+    size_t total = len;
+    for (int i = 0; i < count; i++) {
+        total += strlen(texts[i]) - spans[i].length;
+    }
+
+    char* result = malloc(total + 1);
+    if (!result) {
+        return NULL;
+    }
+    char* out = result;
+    size_t copied = 0;
+    for (int i = 0; i < count; i++) {
+        size_t text_len = strlen(texts[i]);
+        memcpy(out, json + copied, spans[i].offset - copied);
+        out += spans[i].offset - copied;
+        memcpy(out, texts[i], text_len);
+        out += text_len;
+        copied = spans[i].offset + spans[i].length;
+    }
+    memcpy(out, json + copied, len - copied + 1);
+    return result;
+}
+
+// Copy of the object with one member's value replaced by raw JSON text
+char* json_replace_member(const char* json, const char* key, const char* value_json) {
+    const char* end;
+    const char* value = json_object_member(json, key, &end);
+    if (!value) {
+        return NULL;
+    }
+    json_span_t span = make_span(json, value, end);
+    return splice_spans(json, &span, &value_json, 1);
+}
+
+// One tag: an array of strings. Records the spans of the whole tag and of
+// its first two strings; returns one past the tag (NULL if malformed).
+static const char* parse_tag(const char* json, const char* p, nostr_tag_t* tag) {
+    const char* start = p;
+    if (*p++ != '[') {
+        return NULL;
+    }
+    memset(tag, 0, sizeof(*tag));
+
+    p = skip_ws(p);
+    for (int item = 0; *p != ']'; item++) {
+        if (item > 0) {
+            if (*p++ != ',') return NULL;
+            p = skip_ws(p);
+        }
+        const char* end = *p == '"' ? skip_string(p) : NULL;
+        if (!end) {
+            return NULL;
+        }
+        if (item == 0) {
+            tag->name = make_span(json, p, end);
+        } else if (item == 1) {
+            tag->value = make_span(json, p, end);
+        }
+        p = skip_ws(end);
+    }
+    tag->whole = make_span(json, start, p + 1);
+    return p + 1;
+}
+
+// Does the tag start with "nonce"?
+static int is_nonce_tag(const char* json, const nostr_tag_t* tag) {
+    return tag->name.length == 7 && memcmp(json + tag->name.offset, "\"nonce\"", 7) == 0;
+}
+
+// The tags array: every tag's spans, and the first nonce tag
+static const char* parse_tags(const char* json, const char* p, nostr_event_t* ev) {
+    if (*p++ != '[') {
+        return NULL;
+    }
+
+    p = skip_ws(p);
+    while (*p != ']') {
+        if (ev->tag_count > 0) {
+            if (*p++ != ',') return NULL;
+            p = skip_ws(p);
+        }
+
+        if (ev->tag_count == ev->tag_capacity) {
+            int capacity = ev->tag_capacity * 2;
+            nostr_tag_t* grown = ev->tag == ev->inline_tags ? malloc(capacity * sizeof(nostr_tag_t)) :
+                                 realloc(ev->tag, capacity * sizeof(nostr_tag_t));
+            if (!grown) {
+                return NULL;
+            }
+            if (ev->tag == ev->inline_tags) {
+                memcpy(grown, ev->inline_tags, sizeof(ev->inline_tags));
+            }
+            ev->tag = grown;
+            ev->tag_capacity = capacity;
+        }
+
+        nostr_tag_t* tag = &ev->tag[ev->tag_count];
+        if (!(p = parse_tag(json, p, tag))) {
+            return NULL;
+        }
+        if (ev->nonce_tag < 0 && is_nonce_tag(json, tag)) {
+            ev->nonce_tag = ev->tag_count;
+        }
+        ev->tag_count++;
+        p = skip_ws(p);
+    }
+    return p + 1;
+}
+
+// Span a member fills: NULL for members the miner does not use and for repeats
+static json_span_t* event_field(nostr_event_t* ev, const char* name, size_t len) {
+    json_span_t* field = NULL;
+    switch (len) {
+        case 2: field = memcmp(name, "id", 2) == 0 ? &ev->id : NULL; break;
+        case 3: field = memcmp(name, "sig", 3) == 0 ? &ev->sig : NULL; break;
+        case 4: field = memcmp(name, "kind", 4) == 0 ? &ev->kind :
+                        memcmp(name, "tags", 4) == 0 ? &ev->tags : NULL; break;
+        case 6: field = memcmp(name, "pubkey", 6) == 0 ? &ev->pubkey : NULL; break;
+        case 7: field = memcmp(name, "content", 7) == 0 ? &ev->content : NULL; break;
+        case 10: field = memcmp(name, "created_at", 10) == 0 ? &ev->created_at : NULL; break;
+    }
+    return field && field->length == 0 ? field : NULL;
+}
+
+// Tokenize the event in one pass
+int nostr_event_parse(const char* json, nostr_event_t* ev) {
+    memset(ev, 0, sizeof(*ev));
+    ev->tag = ev->inline_tags;
+    ev->tag_capacity = NOSTR_EVENT_INLINE_TAGS;
+    ev->nonce_tag = -1;
+
+    const char* p = skip_ws(json);
+    if (*p++ != '{') {
+        return 0;
+    }
+
+    p = skip_ws(p);
+    while (*p != '}') {
+        const char* name;
+        size_t name_len;
+        const char* value = member_value(p, &name, &name_len);
+        if (!value) {
+            break;
+        }
+
+        // First occurrence wins, as in json_object_member
+        json_span_t* field = event_field(ev, name, name_len);
+        const char* end = field == &ev->tags ? parse_tags(json, value, ev) : skip_value(value);
+        if (!end) {
+            break;
+        }
+        if (field) {
+            *field = make_span(json, value, end);
+        }
+
+        p = skip_ws(end);
+        if (*p == ',') {
+            p = skip_ws(p + 1);
+        } else if (*p != '}') {
+            break;
+        }
+    }
+
+    if (*p != '}') {
+        nostr_event_free(ev);
+        return 0;
+    }
+    return 1;
+}
+
+void nostr_event_free(nostr_event_t* ev) {
+    if (ev->tag != ev->inline_tags) {
+        free(ev->tag);
+    }
+    ev->tag = ev->inline_tags;
+    ev->tag_count = 0;
+}
+
+// Copy of the event with created_at set
+char* set_created_at_in_json(const char* json, uint64_t created_at) {
+    nostr_event_t ev;
+    if (!nostr_event_parse(json, &ev)) {
+        return NULL;
+    }
+    char value[32];
+    const char* text = value;
+    snprintf(value, sizeof(value), "%llu", (unsigned long long)created_at);
+    char* result = ev.created_at.length ? splice_spans(json, &ev.created_at, &text, 1) : NULL;
+    nostr_event_free(&ev);
+    return result;
+}
+
+// Extract field value from JSON
+char* extract_json_field(const char* json, const char* field) {
+    const char* value_end;
+    const char* value_start = json_object_member(json, field, &value_end);
+    if (!value_start) {
+        return NULL;
+    }
+
+    // Strings come back without their quotes (escapes are kept)
+    if (*value_start == '"') {
+        value_start++;
+        value_end--;
+    }
+
+    size_t len = value_end - value_start;
+    char* result = malloc(len + 1);
+    memcpy(result, value_start, len);
+    result[len] = '\0';
+    return result;
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Four hex digits of a \u escape (-1 if malformed)
+static long read_u_escape(const char* p) {
+    long code = 0;
+    for (int i = 0; i < 4; i++) {
+        int digit = hex_digit(p[i]);
+        if (digit < 0) {
+            return -1;
+        }
+        code = code * 16 + digit;
+    }
+    return code;
+}
+
+// Write one code point in NIP-01 form: the seven short escapes, \u00XX for
+// the remaining control characters (as JSON.stringify does), UTF-8 otherwise
+static char* write_code_point(char* out, long code) {
+    static const char hex[] = "0123456789abcdef";
+    switch (code) {
+        case '"':  *out++ = '\\'; *out++ = '"'; return out;
+        case '\\': *out++ = '\\'; *out++ = '\\'; return out;
+        case '\n': *out++ = '\\'; *out++ = 'n'; return out;
+        case '\r': *out++ = '\\'; *out++ = 'r'; return out;
+        case '\t': *out++ = '\\'; *out++ = 't'; return out;
+        case '\b': *out++ = '\\'; *out++ = 'b'; return out;
+        case '\f': *out++ = '\\'; *out++ = 'f'; return out;
+    }
+    if (code < 0x20) {
+        memcpy(out, "\\u00", 4);
+        out[4] = hex[code >> 4];
+        out[5] = hex[code & 0xf];
+        return out + 6;
+    }
+    if (code < 0x80) {
+        *out++ = (char)code;
+    } else if (code < 0x800) {
+        *out++ = (char)(0xc0 | (code >> 6));
+        *out++ = (char)(0x80 | (code & 0x3f));
+    } else if (code < 0x10000) {
+        *out++ = (char)(0xe0 | (code >> 12));
+        *out++ = (char)(0x80 | ((code >> 6) & 0x3f));
+        *out++ = (char)(0x80 | (code & 0x3f));
+    } else {
+        *out++ = (char)(0xf0 | (code >> 18));
+        *out++ = (char)(0x80 | ((code >> 12) & 0x3f));
+        *out++ = (char)(0x80 | ((code >> 6) & 0x3f));
+        *out++ = (char)(0x80 | (code & 0x3f));
+    }
+    return out;
+}
+
+// Re-encode the JSON string at p in NIP-01 form. Escapes are decoded and
+// written back the one canonical way; raw bytes (UTF-8) pass through.
+// Returns one past the closing quote, NULL if malformed.
+static const char* canonical_string(const char* p, char** out) {
+    char* o = *out;
+    if (*p++ != '"') {
+        return NULL;
+    }
+
+    *o++ = '"';
+    while (*p != '"') {
+        unsigned char c = (unsigned char)*p;
+        if (c < 0x20) {
+            return NULL; // Unescaped control characters (and the terminator) are invalid JSON
+        }
+        if (c != '\\') {
+            *o++ = *p++;
+            continue;
+        }
+
+        long code;
+        switch (p[1]) {
+            case '"':  code = '"'; break;
+            case '\\': code = '\\'; break;
+            case '/':  code = '/'; break;
+            case 'b':  code = '\b'; break;
+            case 'f':  code = '\f'; break;
+            case 'n':  code = '\n'; break;
+            case 'r':  code = '\r'; break;
+            case 't':  code = '\t'; break;
+            case 'u':
+                code = read_u_escape(p + 2);
+                if (code >= 0xd800 && code < 0xdc00) {
+                    // Surrogate pair: the low half must follow as another \u escape
+                    long low = p[6] == '\\' && p[7] == 'u' ? read_u_escape(p + 8) : -1;
+                    if (low < 0xdc00 || low > 0xdfff) {
+                        return NULL;
+                    }
+                    code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                    p += 6;
+                } else if (code >= 0xdc00 && code < 0xe000) {
+                    return NULL;
+                }
+                if (code < 0) {
+                    return NULL;
+                }
+                p += 4;
+                break;
+            default:
+                return NULL;
+        }
+        p += 2;
+        o = write_code_point(o, code);
+    }
+
+    *o++ = '"';
+    *out = o;
+    return p + 1;
+}
+
+// Re-encode a non-negative JSON integer without redundant characters
+static const char* canonical_integer(const char* p, char** out) {
+    const char* start = p;
+    unsigned long long value = 0;
+    while (*p >= '0' && *p <= '9') {
+        if (value > (~0ULL - 9) / 10) {
+            return NULL;
+        }
+        value = value * 10 + (*p++ - '0');
+    }
+    if (p == start || (*p && *p != ',' && *p != '}' && *p != ']' && *p != ' ' &&
+                       *p != '\t' && *p != '\n' && *p != '\r')) {
+        return NULL;
+    }
+    *out += sprintf(*out, "%llu", value);
+    return p;
+}
+
+// Re-encode one tag, an array of strings, without whitespace
+static const char* canonical_tag(const char* p, char** out) {
+    if (*p++ != '[') {
+        return NULL;
+    }
+    *(*out)++ = '[';
+
+    p = skip_ws(p);
+    for (int item = 0; *p != ']'; item++) {
+        if (item > 0) {
+            if (*p++ != ',') return NULL;
+            *(*out)++ = ',';
+            p = skip_ws(p);
+        }
+        if (!(p = canonical_string(p, out))) {
+            return NULL;
+        }
+        p = skip_ws(p);
+    }
+    *(*out)++ = ']';
+    return p + 1;
+}
+
+// Write ["nonce","<nonce_str>","<target>"] (no target when 0); returns where the digits start
+static char* write_nonce_tag(char** out, const char* nonce_str, int target) {
+    size_t len = strlen(nonce_str);
+    memcpy(*out, "[\"nonce\",\"", 10);
+    char* digits = *out + 10;
+    memcpy(digits, nonce_str, len);
+    *out = digits + len;
+    if (target > 0) {
+        *out += sprintf(*out, "\",\"%d", target);
+    }
+    memcpy(*out, "\"]", 2);
+    *out += 2;
+    return digits;
+}
+
+// Bytes the target element adds to a nonce tag
+#define NONCE_TARGET_BYTES 16
+
+// Canonical array from the spans, skipping tag skip_tag (-1 for none) and
+// writing a nonce tag before remaining tag insert_at (-1 for none)
+static char* canonical_from_spans(const char* json, const nostr_event_t* ev, int skip_tag, int insert_at,
+                                  const char* nonce_str, int target, size_t* tags_offset, size_t* nonce_offset) {
+    if (!ev->pubkey.length || !ev->created_at.length || !ev->kind.length || !ev->tags.length ||
+        !ev->content.length) {
+        return NULL;
+    }
+
+    // Never longer than the input plus the nonce tag: member names and
+    // whitespace are dropped, and no escape written is longer than the input
+    // form it came from
+    char* canonical = malloc(strlen(json) + 16 + (insert_at >= 0 ? strlen(nonce_str) + 13 + NONCE_TARGET_BYTES : 0));
+    if (!canonical) {
+        return NULL;
+    }
+    char* out = canonical;
+
+    out += sprintf(out, "[0,");
+    int ok = canonical_string(json + ev->pubkey.offset, &out) != NULL;
+    *out++ = ',';
+    ok = ok && canonical_integer(json + ev->created_at.offset, &out);
+    *out++ = ',';
+    ok = ok && canonical_integer(json + ev->kind.offset, &out);
+    *out++ = ',';
+    if (tags_offset) {
+        *tags_offset = out - canonical;
+    }
+
+    *out++ = '[';
+    int written = 0;
+    for (int i = 0; ok && i <= ev->tag_count; i++) {
+        if (written == insert_at) {
+            char* digits = write_nonce_tag(&out, nonce_str, target);
+            if (nonce_offset) {
+                *nonce_offset = digits - canonical;
+            }
+            *out++ = ',';
+            written++;
+        }
+        if (i == ev->tag_count) {
+            break;
+        }
+        if (i != skip_tag) {
+            ok = canonical_tag(json + ev->tag[i].whole.offset, &out) != NULL;
+            *out++ = ',';
+            written++;
+        }
+    }
+    if (written > 0) {
+        out--; // Trailing comma
+    }
+    *out++ = ']';
+
+    *out++ = ',';
+    ok = ok && canonical_string(json + ev->content.offset, &out);
+    *out++ = ']';
+    *out = '\0';
+
+    if (!ok) {
+        free(canonical);
+        return NULL;
+    }
+    return canonical;
+}
+
+char* nostr_event_canonical(const char* json, const nostr_event_t* ev, int nonce_index, const char* nonce_str,
+                            int target, size_t* tags_offset, size_t* nonce_offset) {
+    if (nonce_index == NOSTR_NONCE_KEEP) {
+        return canonical_from_spans(json, ev, -1, -1, NULL, 0, tags_offset, NULL);
+    }
+    return canonical_from_spans(json, ev, ev->nonce_tag, nonce_str ? nonce_index : -1, nonce_str, target,
+                                tags_offset, nonce_offset);
+}
+
+// Build canonical array: [0, pubkey, created_at, kind, tags, content]
+char* build_canonical_event(const char* json, size_t* tags_offset) {
+    nostr_event_t ev;
+    if (!nostr_event_parse(json, &ev)) {
+        return NULL;
+    }
+    char* canonical = nostr_event_canonical(json, &ev, NOSTR_NONCE_KEEP, NULL, 0, tags_offset, NULL);
+    nostr_event_free(&ev);
+    return canonical;
+}
+
+// Calculate Nostr event ID using canonical representation
+void calculate_nostr_event_id(const char* json, uint8_t* id_hash) {
+    char* canonical = build_canonical_event(json, NULL);
+    if (!canonical) {
+        memset(id_hash, 0xff, SHA256_DIGEST_SIZE);
+        return;
+    }
+
+    // Calculate SHA256 hash
+    sha256_hash((uint8_t*)canonical, strlen(canonical), id_hash);
+
+    free(canonical);
+}
+
+// Locate the value of a ["nonce","..."] tag in a tags array
+const char* find_nonce_tag_value(const char* tags, const char** value_end) {
+    const char* p = skip_ws(tags);
+    if (*p++ != '[') {
+        return NULL;
+    }
+
+    p = skip_ws(p);
+    for (int i = 0; *p != ']'; i++) {
+        if (i > 0) {
+            if (*p++ != ',') return NULL;
+            p = skip_ws(p);
+        }
+        nostr_tag_t tag;
+        const char* end = parse_tag(tags, p, &tag);
+        if (!end) {
+            return NULL;
+        }
+        if (is_nonce_tag(tags, &tag) && tag.value.length) {
+            *value_end = tags + tag.value.offset + tag.value.length - 1;
+            return tags + tag.value.offset + 1;
+        }
+        p = skip_ws(end);
+    }
+    return NULL;
+}
+
+// Copy of the event with its tags array rewritten from the spans: tag
+// skip_tag (-1 for none) dropped and a nonce tag written before remaining
+// tag insert_at (-1 for none). Each kept tag is copied verbatim.
+static char* rebuild_tags(const char* json, const nostr_event_t* ev, int skip_tag, int insert_at,
+                          const char* nonce_str, int target) {
+    if (!ev->tags.length) {
+        return NULL;
+    }
+
+    size_t len = strlen(json);
+    char* result = malloc(len + 16 + (insert_at >= 0 ? strlen(nonce_str) + NONCE_TARGET_BYTES : 0));
+    if (!result) {
+        return NULL;
+    }
+    char* out = result;
+    memcpy(out, json, ev->tags.offset);
+    out += ev->tags.offset;
+
+    *out++ = '[';
+    int written = 0;
+    for (int i = 0; i <= ev->tag_count; i++) {
+        if (written == insert_at) {
+            write_nonce_tag(&out, nonce_str, target);
+            *out++ = ',';
+            written++;
+        }
+        if (i == ev->tag_count) {
+            break;
+        }
+        if (i != skip_tag) {
+            memcpy(out, json + ev->tag[i].whole.offset, ev->tag[i].whole.length);
+            out += ev->tag[i].whole.length;
+            *out++ = ',';
+            written++;
+        }
+    }
+    if (written > 0) {
+        out--; // Trailing comma
+    }
+    *out++ = ']';
+
+    size_t rest = ev->tags.offset + ev->tags.length;
+    memcpy(out, json + rest, len - rest + 1);
+    return result;
+}
+
+char* nostr_event_json(const char* json, const nostr_event_t* ev, int nonce_index, const char* nonce_str,
+                       int target) {
+    if (nonce_index == NOSTR_NONCE_KEEP) {
+        return rebuild_tags(json, ev, -1, -1, NULL, 0);
+    }
+    return rebuild_tags(json, ev, ev->nonce_tag, nonce_str ? nonce_index : -1, nonce_str, target);
+}
+
+// Set the nonce tag value in place (adds the tag at the front if missing)
+char* update_nonce_str_in_json(const char* json, const char* nonce_str) {
+    nostr_event_t ev;
+    if (!nostr_event_parse(json, &ev)) {
+        return NULL;
+    }
+
+    char* result;
+    if (ev.nonce_tag >= 0 && ev.tag[ev.nonce_tag].value.length) {
+        // Keep the quotes, replace what is between them
+        json_span_t digits = ev.tag[ev.nonce_tag].value;
+        digits.offset++;
+        digits.length -= 2;
+        result = splice_spans(json, &digits, &nonce_str, 1);
+    } else {
+        result = rebuild_tags(json, &ev, ev.nonce_tag, 0, nonce_str, 0);
+    }
+    nostr_event_free(&ev);
+    return result;
+}
+
+char* update_nonce_in_json(const char* json, uint64_t nonce) {
+    char nonce_str[32];
+    sprintf(nonce_str, "%llu", (unsigned long long)nonce);
+    return update_nonce_str_in_json(json, nonce_str);
+}
+
+// Top-level elements of a JSON array as [start, end) offsets from the '['
+int json_array_elements(const char* array, size_t* starts, size_t* ends, int max_elements) {
+    const char* p = array;
+    int count = 0;
+    if (*p++ != '[') {
+        return -1;
+    }
+
+    p = skip_ws(p);
+    while (*p != ']') {
+        if (count > 0) {
+            if (*p++ != ',') return -1;
+            p = skip_ws(p);
+        }
+        const char* end = skip_value(p);
+        if (!end) {
+            return -1;
+        }
+        if (count < max_elements) {
+            starts[count] = p - array;
+            ends[count] = end - array;
+        }
+        count++;
+        p = skip_ws(end);
+    }
+    return count;
+}
+
+// Copy of the event without its ["nonce",...] tag
+char* remove_nonce_tag_from_json(const char* json) {
+    nostr_event_t ev;
+    if (!nostr_event_parse(json, &ev)) {
+        return NULL;
+    }
+    char* result = nostr_event_json(json, &ev, NOSTR_NONCE_DROP, NULL, 0);
+    nostr_event_free(&ev);
+    return result;
+}
+
+// Insert ["nonce","<nonce_str>"] before tag `index` (index == tag count appends)
+char* insert_nonce_tag_in_json(const char* json, int index, const char* nonce_str) {
+    nostr_event_t ev;
+    if (!nostr_event_parse(json, &ev)) {
+        return NULL;
+    }
+    char* result = index >= 0 && index <= ev.tag_count ? rebuild_tags(json, &ev, -1, index, nonce_str, 0) : NULL;
+    nostr_event_free(&ev);
+    return result;
+}
+
+// Set the event ID and clear signature
+char* set_event_id_and_clear_sig(const char* json, const char* id_hex) {
+    nostr_event_t ev;
+    if (!nostr_event_parse(json, &ev)) {
+        return NULL;
+    }
+
+    char id_json[2 * SHA256_DIGEST_SIZE + 3];
+    snprintf(id_json, sizeof(id_json), "\"%s\"", id_hex);
+
+    // Both edits in one copy; events without an id or sig member keep the rest unchanged
+    json_span_t spans[2];
+    const char* texts[2];
+    int count = 0;
+    if (ev.id.length) {
+        spans[count] = ev.id;
+        texts[count++] = id_json;
+    }
+    if (ev.sig.length) {
+        spans[count] = ev.sig;
+        texts[count++] = "\"\"";
+    }
+    if (count == 2 && spans[0].offset > spans[1].offset) {
+        json_span_t span = spans[0];
+        const char* text = texts[0];
+        spans[0] = spans[1];
+        texts[0] = texts[1];
+        spans[1] = span;
+        texts[1] = text;
+    }
+
+    char* result = splice_spans(json, spans, texts, count);
+    nostr_event_free(&ev);
+    return result;
+}
+
+// Read one line of any length (caller frees, NULL at end of input)
+char* nostr_read_line(FILE* fp) {
+    size_t capacity = 4096;
+    size_t len = 0;
+    char* line = malloc(capacity);
+    if (!line) {
+        return NULL;
+    }
+
+    while (fgets(line + len, (int)(capacity - len), fp)) {
+        len += strlen(line + len);
+        if (len > 0 && line[len - 1] == '\n') {
+            break;
+        }
+        if (len + 1 == capacity) {
+            char* grown = realloc(line, capacity * 2);
+            if (!grown) {
+                break;
+            }
+            line = grown;
+            capacity *= 2;
+        }
+    }
+
+    if (len == 0) {
+        free(line);
+        return NULL;
+    }
+    return line;
+}
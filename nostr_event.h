@@ -0,0 +1,119 @@
+/*
+ * Nostr event JSON helpers shared by the NIP-13 miners
+ * A single-pass tokenizer records where each field and tag lives; every
+ * rewrite and the canonical serialization work from those spans. No JSON
+ * library required.
+ */
+
+#ifndef NOSTR_EVENT_H
+#define NOSTR_EVENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Bytes [offset, offset + length) of the event text; length 0 when absent
+typedef struct {
+    size_t offset;
+    size_t length;
+} json_span_t;
+
+// One tag; string spans include their quotes
+typedef struct {
+    json_span_t whole;              // The tag array
+    json_span_t name;               // First string
+    json_span_t value;              // Second string
+} nostr_tag_t;
+
+#define NOSTR_EVENT_INLINE_TAGS 16
+
+// Spans of a tokenized event. Values are raw JSON text (strings keep their
+// quotes and escapes); for repeated members the first one counts. Points
+// into itself for small events, so pass it by pointer rather than copying.
+typedef struct {
+    json_span_t id;
+    json_span_t pubkey;
+    json_span_t created_at;
+    json_span_t kind;
+    json_span_t tags;
+    json_span_t content;
+    json_span_t sig;
+    nostr_tag_t* tag;               // tag_count tags in order
+    int tag_count;
+    int tag_capacity;
+    int nonce_tag;                  // First ["nonce",...] tag, -1 if none
+    nostr_tag_t inline_tags[NOSTR_EVENT_INLINE_TAGS];
+} nostr_event_t;
+
+// Tokenize a top-level event object in one pass without copying it. Tags
+// must be arrays of strings; missing members are left empty. Returns 0 if
+// the event is malformed (nothing to free then).
+int nostr_event_parse(const char* json, nostr_event_t* ev);
+void nostr_event_free(nostr_event_t* ev);
+
+// nonce_index values for the nonce tag rewrites below
+#define NOSTR_NONCE_KEEP (-1)       // Keep the tags as they are
+#define NOSTR_NONCE_DROP (-2)       // Leave the nonce tag out
+
+// Canonical array of a tokenized event. Unless nonce_index is
+// NOSTR_NONCE_KEEP the event's own nonce tag is left out and, when nonce_str
+// is set, ["nonce","<nonce_str>","<target>"] (NIP-13: the target difficulty
+// the proof commits to; no third element when target is 0) goes before the
+// nonce_index-th remaining tag. tags_offset and nonce_offset (optional)
+// receive the offsets of the tags array and of the nonce digits. NULL on
+// malformed events.
+char* nostr_event_canonical(const char* json, const nostr_event_t* ev, int nonce_index, const char* nonce_str,
+                            int target, size_t* tags_offset, size_t* nonce_offset);
+
+// Event JSON with the nonce tag rewritten as for nostr_event_canonical; the
+// other tags and members are copied verbatim (caller frees)
+char* nostr_event_json(const char* json, const nostr_event_t* ev, int nonce_index, const char* nonce_str,
+                       int target);
+
+// Value of a top-level member of a JSON object: its first byte, with one
+// past its last in value_end (NULL if missing or the object is malformed)
+const char* json_object_member(const char* json, const char* key, const char** value_end);
+
+// Copy of the object with one member's value replaced by raw JSON text (NULL if missing)
+char* json_replace_member(const char* json, const char* key, const char* value_json);
+
+// Copy of the event with created_at set (NULL if it has no created_at)
+char* set_created_at_in_json(const char* json, uint64_t created_at);
+
+// Extract field value from JSON (caller frees, NULL if missing)
+char* extract_json_field(const char* json, const char* field);
+
+// Build canonical array: [0, pubkey, created_at, kind, tags, content]
+// in NIP-01 form: no whitespace, strings re-escaped, tags checked to be
+// arrays of strings. NULL on malformed events. tags_offset (optional)
+// receives the offset of the tags array.
+char* build_canonical_event(const char* json, size_t* tags_offset);
+
+// Calculate Nostr event ID using canonical representation
+void calculate_nostr_event_id(const char* json, uint8_t* id_hash);
+
+// Locate the value of a ["nonce","..."] tag in a tags array
+const char* find_nonce_tag_value(const char* tags, const char** value_end);
+
+// Set the nonce tag value, keeping its target (adds the tag if missing)
+char* update_nonce_str_in_json(const char* json, const char* nonce_str);
+char* update_nonce_in_json(const char* json, uint64_t nonce);
+
+// Top-level elements of a JSON array as [start, end) offsets from the '['.
+// Returns the element count (offsets are only stored for the first
+// max_elements), or -1 if the array is malformed.
+int json_array_elements(const char* array, size_t* starts, size_t* ends, int max_elements);
+
+// Copy of the event without its ["nonce",...] tag (NULL if there is no tags array)
+char* remove_nonce_tag_from_json(const char* json);
+
+// Insert ["nonce","<nonce_str>"] before tag `index` (index == tag count appends)
+char* insert_nonce_tag_in_json(const char* json, int index, const char* nonce_str);
+
+// Set the event ID and clear signature (NULL on malformed events)
+char* set_event_id_and_clear_sig(const char* json, const char* id_hex);
+
+// Read one line of JSONL input of any length (caller frees, NULL at end of input)
+char* nostr_read_line(FILE* fp);
+
+#endif
@@ -0,0 +1,137 @@
+/*
+ * Per-thread hardware performance counters for the parallel miner
+ * One perf_event_open group per thread, read with a single syscall
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <errno.h>
+#include <string.h>
+
+#include "perf_counters.h"
+
+#ifdef __linux__
+
+static const uint64_t event_configs[PERF_EVENT_COUNT] = {
+    [PERF_CYCLES] = PERF_COUNT_HW_CPU_CYCLES,
+    [PERF_INSTRUCTIONS] = PERF_COUNT_HW_INSTRUCTIONS,
+    [PERF_CACHE_MISSES] = PERF_COUNT_HW_CACHE_MISSES,
+    [PERF_BRANCH_MISSES] = PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+// Count one hardware event of the calling thread on any CPU it runs on
+static int open_event(uint64_t config, int group_fd) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = group_fd < 0;   // The leader starts the whole group once it is complete
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC);
+}
+
+int perf_counters_open(perf_counters_t* counters) {
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+        counters->fds[i] = -1;
+        counters->slots[i] = -1;
+    }
+    counters->members = 0;
+
+    int leader = open_event(event_configs[PERF_CYCLES], -1);
+    if (leader < 0) {
+        return 0;
+    }
+    counters->fds[PERF_CYCLES] = leader;
+    counters->slots[PERF_CYCLES] = counters->members++;
+
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+        if (i == PERF_CYCLES) {
+            continue;
+        }
+        int fd = open_event(event_configs[i], leader);
+        if (fd >= 0) {
+            counters->fds[i] = fd;
+            counters->slots[i] = counters->members++;
+        }
+    }
+
+    if (ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) < 0) {
+        int error = errno;
+        perf_counters_close(counters);
+        errno = error;
+        return 0;
+    }
+    return 1;
+}
+
+int perf_counters_read(const perf_counters_t* counters, perf_sample_t* sample) {
+    // nr, time_enabled, time_running, then one value per member
+    uint64_t buf[3 + PERF_EVENT_COUNT];
+    memset(sample, 0, sizeof(*sample));
+    if (counters->fds[PERF_CYCLES] < 0) {
+        return 0;
+    }
+    ssize_t size = read(counters->fds[PERF_CYCLES], buf, sizeof(buf));
+    if (size < (ssize_t)(3 * sizeof(uint64_t)) || buf[0] != (uint64_t)counters->members || buf[2] == 0) {
+        return 0;
+    }
+
+    // More groups than hardware counters: the kernel time-slices them, and
+    // the totals are extrapolated from the share of time actually counted
+    uint64_t enabled = buf[1];
+    uint64_t running = buf[2];
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+        if (counters->slots[i] < 0) {
+            continue;
+        }
+        uint64_t value = buf[3 + counters->slots[i]];
+        sample->values[i] = running < enabled ? (uint64_t)((double)value * enabled / running) : value;
+        sample->valid |= 1u << i;
+    }
+    sample->time_ns = enabled;
+    return 1;
+}
+
+void perf_counters_close(perf_counters_t* counters) {
+    // Members first, then the leader
+    for (int i = PERF_EVENT_COUNT - 1; i >= 0; i--) {
+        if (counters->fds[i] >= 0) {
+            close(counters->fds[i]);
+            counters->fds[i] = -1;
+        }
+    }
+    counters->members = 0;
+}
+
+#else
+
+int perf_counters_open(perf_counters_t* counters) {
+    for (int i = 0; i < PERF_EVENT_COUNT; i++) {
+        counters->fds[i] = -1;
+        counters->slots[i] = -1;
+    }
+    counters->members = 0;
+    errno = ENOSYS;
+    return 0;
+}
+
+int perf_counters_read(const perf_counters_t* counters, perf_sample_t* sample) {
+    (void)counters;
+    memset(sample, 0, sizeof(*sample));
+    return 0;
+}
+
+void perf_counters_close(perf_counters_t* counters) {
+    counters->members = 0;
+}
+
+#endif
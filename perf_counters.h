@@ -0,0 +1,45 @@
+/*
+ * Per-thread hardware performance counters for the parallel miner
+ * Uses perf_event_open on Linux, counting user space only so the default
+ * perf_event_paranoid of 2 is enough; elsewhere, and in containers or VMs
+ * without a virtual PMU, opening fails and the miner runs uncounted.
+ */
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdint.h>
+
+// Events of one group, read together
+typedef enum {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_CACHE_MISSES,              // Last-level cache misses
+    PERF_BRANCH_MISSES,
+    PERF_EVENT_COUNT
+} perf_event_t;
+
+// Counter group of the thread that opened it
+typedef struct {
+    int fds[PERF_EVENT_COUNT];      // fds[PERF_CYCLES] leads the group; -1 if not opened
+    int slots[PERF_EVENT_COUNT];    // Position of each event in a group read, -1 if missing
+    int members;
+} perf_counters_t;
+
+// Running totals, scaled up when the kernel multiplexed the counters
+typedef struct {
+    uint64_t values[PERF_EVENT_COUNT];
+    uint64_t time_ns;               // Time the thread ran with the group enabled
+    unsigned valid;                 // Bit (1 << event) for every event counted
+} perf_sample_t;
+
+// Open and start the group on the calling thread. Events the CPU lacks are
+// left out; returns 0 (errno set) when not even cycles can be counted.
+int perf_counters_open(perf_counters_t* counters);
+
+// Returns 0 when the group cannot be read
+int perf_counters_read(const perf_counters_t* counters, perf_sample_t* sample);
+
+void perf_counters_close(perf_counters_t* counters);
+
+#endif
@@ -0,0 +1,435 @@
+/*
+ * SHA256 primitives shared by the NIP-13 miners
+ * Simplified implementation based on hashcat primitives
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "sha256.h"
+
+// SHA256 constants (from hashcat)
+const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+// Rotate right
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+// SHA256 functions (optimized versions from hashcat)
+#define CH(x, y, z)  (((x) & (y)) ^ (~(x) & (z)))
+#define MAJ(x, y, z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define S0(x)        (ROTR(x,  2) ^ ROTR(x, 13) ^ ROTR(x, 22))
+#define S1(x)        (ROTR(x,  6) ^ ROTR(x, 11) ^ ROTR(x, 25))
+#define s0(x)        (ROTR(x,  7) ^ ROTR(x, 18) ^ ((x) >>  3))
+#define s1(x)        (ROTR(x, 17) ^ ROTR(x, 19) ^ ((x) >> 10))
+
+// Initialize SHA256 context
+void sha256_init(sha256_ctx_t *ctx) {
+    ctx->state[0] = 0x6a09e667;
+    ctx->state[1] = 0xbb67ae85;
+    ctx->state[2] = 0x3c6ef372;
+    ctx->state[3] = 0xa54ff53a;
+    ctx->state[4] = 0x510e527f;
+    ctx->state[5] = 0x9b05688c;
+    ctx->state[6] = 0x1f83d9ab;
+    ctx->state[7] = 0x5be0cd19;
+    ctx->count = 0;
+}
+
+// Process a single 512-bit block (optimized from hashcat)
+void sha256_transform_scalar(uint32_t *state, const uint8_t *data) {
+    uint32_t w[64];
+    uint32_t a, b, c, d, e, f, g, h;
+    uint32_t t1, t2;
+
+    // Prepare message schedule
+    for (int i = 0; i < 16; i++) {
+        w[i] = (data[i * 4] << 24) | (data[i * 4 + 1] << 16) |
+               (data[i * 4 + 2] << 8) | data[i * 4 + 3];
+    }
+
+    for (int i = 16; i < 64; i++) {
+        w[i] = s1(w[i - 2]) + w[i - 7] + s0(w[i - 15]) + w[i - 16];
+    }
+
+    // Initialize working variables
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+    f = state[5];
+    g = state[6];
+    h = state[7];
+
+    // Main loop (unrolled for performance like hashcat)
+    for (int i = 0; i < 64; i++) {
+        t1 = h + S1(e) + CH(e, f, g) + sha256_k[i] + w[i];
+        t2 = S0(a) + MAJ(a, b, c);
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    // Add compressed chunk to current hash value
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+// Compression backend, chosen once at startup before any thread runs
+static sha256_block_fn sha256_block = sha256_transform_scalar;
+static const char *sha256_block_name = "scalar";
+
+__attribute__((constructor))
+static void sha256_select_backend(void) {
+    if (sha256_shani_supported()) {
+        sha256_block = sha256_transform_shani;
+        sha256_block_name = "shani";
+    }
+}
+
+// Process a single 512-bit block with the fastest backend for this CPU
+void sha256_transform(sha256_ctx_t *ctx, const uint8_t *data) {
+    sha256_block(ctx->state, data);
+}
+
+// Same as sha256_transform, on a bare state array
+void sha256_compress(uint32_t *state, const uint8_t *data) {
+    sha256_block(state, data);
+}
+
+// Masks over state[0]/state[1] that must be zero for `bits` leading zero bits
+void sha256_zero_masks(int bits, uint32_t *mask0, uint32_t *mask1) {
+    if (bits <= 0) {
+        *mask0 = 0;
+        *mask1 = 0;
+    } else if (bits <= 32) {
+        *mask0 = 0xffffffffu << (32 - bits);
+        *mask1 = 0;
+    } else {
+        *mask0 = 0xffffffffu;
+        *mask1 = bits >= 64 ? 0xffffffffu : 0xffffffffu << (64 - bits);
+    }
+}
+
+// Fused hash-and-test for the final block (scalar rounds)
+// Only state[0] and state[1] are produced: the other six final additions
+// and the digest serialization are skipped. b after the last round is a
+// from round 63, so when state[1] is part of the target a miss is rejected
+// before the final round is computed.
+static int sha256_compress_test_scalar(const uint32_t *state, const uint8_t *data,
+                                       uint32_t mask0, uint32_t mask1,
+                                       uint32_t *h0, uint32_t *h1) {
+    uint32_t w[64];
+    uint32_t a, b, c, d, e, f, g, h;
+    uint32_t t1, t2;
+
+    for (int i = 0; i < 16; i++) {
+        w[i] = (data[i * 4] << 24) | (data[i * 4 + 1] << 16) |
+               (data[i * 4 + 2] << 8) | data[i * 4 + 3];
+    }
+
+    for (int i = 16; i < 64; i++) {
+        w[i] = s1(w[i - 2]) + w[i - 7] + s0(w[i - 15]) + w[i - 16];
+    }
+
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+    f = state[5];
+    g = state[6];
+    h = state[7];
+
+    for (int i = 0; i < 63; i++) {
+        t1 = h + S1(e) + CH(e, f, g) + sha256_k[i] + w[i];
+        t2 = S0(a) + MAJ(a, b, c);
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    // Early reject on state[1] before the final round
+    *h1 = state[1] + a;
+    if (*h1 & mask1) {
+        *h0 = 0xffffffffu;
+        return 0;
+    }
+
+    // Final round: only the new a is needed
+    t1 = h + S1(e) + CH(e, f, g) + sha256_k[63] + w[63];
+    t2 = S0(a) + MAJ(a, b, c);
+    *h0 = state[0] + t1 + t2;
+    return (*h0 & mask0) == 0;
+}
+
+// Evaluate the nonce-independent part of a block starting from state
+void sha256_precomp_init(sha256_precomp_t *pc, const uint32_t *state, const uint8_t *data,
+                         int var_first, int var_last) {
+    uint32_t w[64];
+    uint32_t a, b, c, d, e, f, g, h;
+    uint32_t t1, t2;
+
+    if (var_last > 15) {
+        var_last = 15;
+    }
+
+    for (int i = 0; i < 16; i++) {
+        w[i] = (data[i * 4] << 24) | (data[i * 4 + 1] << 16) |
+               (data[i * 4 + 2] << 8) | data[i * 4 + 3];
+        pc->dep[i] = (i >= var_first && i <= var_last);
+        pc->terms[i] = 0;
+        pc->part[i] = pc->dep[i] ? 0 : w[i] + sha256_k[i];
+    }
+
+    // Split each schedule word into constant and changing terms
+    for (int i = 16; i < 64; i++) {
+        w[i] = s1(w[i - 2]) + w[i - 7] + s0(w[i - 15]) + w[i - 16];
+
+        uint8_t terms = (pc->dep[i - 2] ? 1 : 0) | (pc->dep[i - 7] ? 2 : 0) |
+                        (pc->dep[i - 15] ? 4 : 0) | (pc->dep[i - 16] ? 8 : 0);
+        pc->dep[i] = terms != 0;
+        pc->terms[i] = terms;
+
+        if (terms) {
+            uint32_t part = 0;
+            if (!(terms & 1)) part += s1(w[i - 2]);
+            if (!(terms & 2)) part += w[i - 7];
+            if (!(terms & 4)) part += s0(w[i - 15]);
+            if (!(terms & 8)) part += w[i - 16];
+            pc->part[i] = part;
+        } else {
+            pc->part[i] = w[i] + sha256_k[i];
+        }
+    }
+
+    // Rounds before the first changing word are identical for every attempt
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+    f = state[5];
+    g = state[6];
+    h = state[7];
+
+    for (int i = 0; i < var_first && i < 64; i++) {
+        t1 = h + S1(e) + CH(e, f, g) + sha256_k[i] + w[i];
+        t2 = S0(a) + MAJ(a, b, c);
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    pc->start_round = var_first < 64 ? var_first : 64;
+    pc->state[0] = a;
+    pc->state[1] = b;
+    pc->state[2] = c;
+    pc->state[3] = d;
+    pc->state[4] = e;
+    pc->state[5] = f;
+    pc->state[6] = g;
+    pc->state[7] = h;
+}
+
+// Finish a precomputed block, reading only the changing words from data
+static void sha256_compress_precomp_scalar(const sha256_precomp_t *pc, uint32_t *state,
+                                           const uint8_t *data) {
+    uint32_t w[64];
+    uint32_t a, b, c, d, e, f, g, h;
+    uint32_t t1, t2, wk;
+
+    for (int i = 0; i < 16; i++) {
+        if (pc->dep[i]) {
+            w[i] = (data[i * 4] << 24) | (data[i * 4 + 1] << 16) |
+                   (data[i * 4 + 2] << 8) | data[i * 4 + 3];
+        }
+    }
+
+    a = pc->state[0];
+    b = pc->state[1];
+    c = pc->state[2];
+    d = pc->state[3];
+    e = pc->state[4];
+    f = pc->state[5];
+    g = pc->state[6];
+    h = pc->state[7];
+
+    for (int i = pc->start_round; i < 64; i++) {
+        if (pc->dep[i]) {
+            if (i >= 16) {
+                uint32_t v = pc->part[i];
+                uint8_t terms = pc->terms[i];
+                if (terms & 1) v += s1(w[i - 2]);
+                if (terms & 2) v += w[i - 7];
+                if (terms & 4) v += s0(w[i - 15]);
+                if (terms & 8) v += w[i - 16];
+                w[i] = v;
+            }
+            wk = w[i] + sha256_k[i];
+        } else {
+            wk = pc->part[i];
+        }
+
+        t1 = h + S1(e) + CH(e, f, g) + wk;
+        t2 = S0(a) + MAJ(a, b, c);
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+// Hardware backends run the whole block; their rounds cannot start mid-block
+void sha256_compress_precomp(const sha256_precomp_t *pc, uint32_t *state, const uint8_t *data) {
+    if (sha256_block == sha256_transform_scalar) {
+        sha256_compress_precomp_scalar(pc, state, data);
+    } else {
+        sha256_block(state, data);
+    }
+}
+
+// Compress the final block and test state[0]/state[1] against the masks
+int sha256_compress_test(const uint32_t *state, const uint8_t *data,
+                         uint32_t mask0, uint32_t mask1, uint32_t *h0, uint32_t *h1) {
+    if (sha256_block == sha256_transform_scalar) {
+        return sha256_compress_test_scalar(state, data, mask0, mask1, h0, h1);
+    }
+
+    // Hardware rounds produce the whole state in one go
+    uint32_t out[8];
+    memcpy(out, state, sizeof(out));
+    sha256_block(out, data);
+    *h0 = out[0];
+    *h1 = out[1];
+    return (out[0] & mask0) == 0 && (out[1] & mask1) == 0;
+}
+
+// Look up a compression backend by name ("scalar", "shani"); NULL if unsupported
+sha256_block_fn sha256_backend_lookup(const char *name) {
+    if (strcmp(name, "scalar") == 0) {
+        return sha256_transform_scalar;
+    }
+    if (strcmp(name, "shani") == 0 && sha256_shani_supported()) {
+        return sha256_transform_shani;
+    }
+    return NULL;
+}
+
+// Name of the backend used by sha256_transform
+const char *sha256_backend_name(void) {
+    return sha256_block_name;
+}
+
+// Update SHA256 with new data
+void sha256_update(sha256_ctx_t *ctx, const uint8_t *data, size_t len) {
+    size_t buffer_space = 64 - (ctx->count % 64);
+
+    ctx->count += len;
+
+    if (len >= buffer_space) {
+        memcpy(ctx->buffer + (64 - buffer_space), data, buffer_space);
+        sha256_transform(ctx, ctx->buffer);
+        data += buffer_space;
+        len -= buffer_space;
+
+        while (len >= 64) {
+            sha256_transform(ctx, data);
+            data += 64;
+            len -= 64;
+        }
+    }
+
+    if (len > 0) {
+        memcpy(ctx->buffer + (ctx->count % 64) - len, data, len);
+    }
+}
+
+// Serialize the eight state words as a big-endian digest
+void sha256_state_to_digest(const uint32_t *state, uint8_t *digest) {
+    for (int i = 0; i < 8; i++) {
+        digest[i * 4] = (state[i] >> 24) & 0xff;
+        digest[i * 4 + 1] = (state[i] >> 16) & 0xff;
+        digest[i * 4 + 2] = (state[i] >> 8) & 0xff;
+        digest[i * 4 + 3] = state[i] & 0xff;
+    }
+}
+
+// Finalize SHA256 and output digest
+void sha256_final(sha256_ctx_t *ctx, uint8_t *digest) {
+    uint64_t bit_count = ctx->count * 8;
+    size_t pad_len = (ctx->count % 64 < 56) ? (56 - ctx->count % 64) : (120 - ctx->count % 64);
+
+    uint8_t padding[64] = {0x80};
+    sha256_update(ctx, padding, pad_len);
+
+    // Append length in bits as big-endian 64-bit integer
+    uint8_t len_bytes[8];
+    for (int i = 7; i >= 0; i--) {
+        len_bytes[i] = bit_count & 0xff;
+        bit_count >>= 8;
+    }
+    sha256_update(ctx, len_bytes, 8);
+
+    // Output final hash
+    sha256_state_to_digest(ctx->state, digest);
+}
+
+// Complete SHA256 hash in one call
+void sha256_hash(const uint8_t *data, size_t len, uint8_t *digest) {
+    sha256_ctx_t ctx;
+    sha256_init(&ctx);
+    sha256_update(&ctx, data, len);
+    sha256_final(&ctx, digest);
+}
+
+// Convert hash to hex string
+void hash_to_hex(const uint8_t *hash, char *hex_str) {
+    for (int i = 0; i < SHA256_DIGEST_SIZE; i++) {
+        sprintf(hex_str + i * 2, "%02x", hash[i]);
+    }
+    hex_str[64] = '\0';
+}
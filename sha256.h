@@ -0,0 +1,87 @@
+/*
+ * SHA256 primitives shared by the NIP-13 miners
+ * Simplified implementation based on hashcat primitives
+ */
+
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SHA256_DIGEST_SIZE 32
+#define SHA256_BLOCK_SIZE  64
+
+// SHA256 round constants (from hashcat)
+extern const uint32_t sha256_k[64];
+
+// SHA256 context
+typedef struct {
+    uint32_t state[8];
+    uint64_t count;
+    uint8_t buffer[64];
+} sha256_ctx_t;
+
+// Single-block compression function shared by every backend
+typedef void (*sha256_block_fn)(uint32_t *state, const uint8_t *data);
+
+// Nonce-independent work for a block whose words var_first..var_last change
+// per attempt: the rounds before the first changing word and every message
+// schedule term that only reads constant words are evaluated once per job.
+typedef struct {
+    uint32_t state[8];      // Working variables a..h after start_round rounds
+    int start_round;        // First round that reads a changing word
+    uint8_t dep[64];        // w[i] depends on the changing words
+    uint8_t terms[64];      // Changing terms of w[i]: 1 s1(w[i-2]), 2 w[i-7], 4 s0(w[i-15]), 8 w[i-16]
+    uint32_t part[64];      // Constant part of a changing w[i]; w[i] + K[i] for constant words
+} sha256_precomp_t;
+
+void sha256_init(sha256_ctx_t *ctx);
+
+// Process one block with the backend selected at startup via cpuid
+void sha256_transform(sha256_ctx_t *ctx, const uint8_t *data);
+
+// Same as sha256_transform, on a bare state array
+void sha256_compress(uint32_t *state, const uint8_t *data);
+
+// Masks over state[0]/state[1] that must be zero for `bits` leading zero bits
+void sha256_zero_masks(int bits, uint32_t *mask0, uint32_t *mask1);
+
+// Fused hash-and-test for the final (already padded) block: produces only
+// the first two digest words and returns 1 when both masked words are zero.
+// When mask1 rejects, *h0 is not computed and is set to 0xffffffff.
+int sha256_compress_test(const uint32_t *state, const uint8_t *data,
+                         uint32_t mask0, uint32_t mask1, uint32_t *h0, uint32_t *h1);
+
+// Evaluate the nonce-independent part of a block starting from state
+void sha256_precomp_init(sha256_precomp_t *pc, const uint32_t *state, const uint8_t *data,
+                         int var_first, int var_last);
+
+// Finish a precomputed block: only changing words are read from data and
+// the result is added into state. Hardware backends compress the whole block.
+void sha256_compress_precomp(const sha256_precomp_t *pc, uint32_t *state, const uint8_t *data);
+
+// Portable backend built on the CH/MAJ/S0/S1 macros
+void sha256_transform_scalar(uint32_t *state, const uint8_t *data);
+
+// Intel SHA extensions backend (sha256rnds2/sha256msg1/sha256msg2)
+void sha256_transform_shani(uint32_t *state, const uint8_t *data);
+int sha256_shani_supported(void);
+
+// Look up a backend by name ("scalar", "shani"); NULL if this CPU lacks it
+sha256_block_fn sha256_backend_lookup(const char *name);
+
+// Name of the backend used by sha256_transform
+const char *sha256_backend_name(void);
+
+void sha256_update(sha256_ctx_t *ctx, const uint8_t *data, size_t len);
+void sha256_final(sha256_ctx_t *ctx, uint8_t *digest);
+void sha256_hash(const uint8_t *data, size_t len, uint8_t *digest);
+
+// Serialize the eight state words as a big-endian digest
+void sha256_state_to_digest(const uint32_t *state, uint8_t *digest);
+
+// Convert hash to hex string (hex_str must hold 65 bytes)
+void hash_to_hex(const uint8_t *hash, char *hex_str);
+
+#endif
@@ -0,0 +1,97 @@
+/*
+ * SHA256 compression using the Intel SHA extensions
+ * Compiled with a per-function target attribute so the rest of the binary
+ * stays portable; sha256_transform only routes here when cpuid reports SHA.
+ */
+
+#include "sha256.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+#include <immintrin.h>
+
+// SHA (leaf 7 EBX bit 29) plus the SSSE3/SSE4.1 shuffles and blends used below
+int sha256_shani_supported(void) {
+    unsigned int eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return 0;
+    }
+    if (!(ecx & bit_SSSE3) || !(ecx & bit_SSE4_1)) {
+        return 0;
+    }
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return 0;
+    }
+    return (ebx & (1u << 29)) != 0;
+}
+
+__attribute__((target("sha,ssse3,sse4.1")))
+void sha256_transform_shani(uint32_t *state, const uint8_t *data) {
+    const __m128i byteswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i state0, state1, msg, tmp, abef_save, cdgh_save;
+    __m128i m[4];
+
+    // Reorder state words into the ABEF/CDGH layout sha256rnds2 expects
+    tmp = _mm_loadu_si128((const __m128i *)&state[0]);
+    state1 = _mm_loadu_si128((const __m128i *)&state[4]);
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);
+    state1 = _mm_shuffle_epi32(state1, 0x1B);
+    state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    abef_save = state0;
+    cdgh_save = state1;
+
+    // 16 groups of four rounds; the schedule for group g + 1 is finished
+    // while group g runs, and sha256msg1 starts the one after that
+    for (int g = 0; g < 16; g++) {
+        __m128i *cur = &m[g & 3];
+        __m128i *prev = &m[(g + 3) & 3];
+        __m128i *next = &m[(g + 1) & 3];
+
+        if (g < 4) {
+            *cur = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + g * 16)), byteswap);
+        }
+
+        msg = _mm_add_epi32(*cur, _mm_loadu_si128((const __m128i *)&sha256_k[g * 4]));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+
+        if (g >= 3 && g <= 14) {
+            tmp = _mm_alignr_epi8(*cur, *prev, 4);
+            *next = _mm_add_epi32(*next, tmp);
+            *next = _mm_sha256msg2_epu32(*next, *cur);
+        }
+
+        msg = _mm_shuffle_epi32(msg, 0x0E);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+
+        if (g >= 1 && g <= 12) {
+            *prev = _mm_sha256msg1_epu32(*prev, *cur);
+        }
+    }
+
+    state0 = _mm_add_epi32(state0, abef_save);
+    state1 = _mm_add_epi32(state1, cdgh_save);
+
+    // Back to the ABCD/EFGH word order
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+
+    _mm_storeu_si128((__m128i *)&state[0], state0);
+    _mm_storeu_si128((__m128i *)&state[4], state1);
+}
+
+#else
+
+int sha256_shani_supported(void) {
+    return 0;
+}
+
+void sha256_transform_shani(uint32_t *state, const uint8_t *data) {
+    sha256_transform_scalar(state, data);
+}
+
+#endif
@@ -0,0 +1,280 @@
+/*
+ * Multi-buffer SHA256 kernels (AVX2 x8, AVX-512 x16)
+ * Same round structure as sha256_transform, one message per vector lane
+ */
+
+#include "sha256.h"
+#include "sha256_simd.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define SHA256_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+#ifdef SHA256_SIMD_X86
+
+// AVX2: 8 lanes
+#define V8_ROTR(x, n) _mm256_or_si256(_mm256_srli_epi32((x), (n)), _mm256_slli_epi32((x), 32 - (n)))
+#define V8_CH(x, y, z)  _mm256_xor_si256(_mm256_and_si256((x), (y)), _mm256_andnot_si256((x), (z)))
+#define V8_MAJ(x, y, z) _mm256_or_si256(_mm256_and_si256((x), (y)), _mm256_and_si256(_mm256_or_si256((x), (y)), (z)))
+#define V8_S0(x) _mm256_xor_si256(V8_ROTR(x, 2), _mm256_xor_si256(V8_ROTR(x, 13), V8_ROTR(x, 22)))
+#define V8_S1(x) _mm256_xor_si256(V8_ROTR(x, 6), _mm256_xor_si256(V8_ROTR(x, 11), V8_ROTR(x, 25)))
+#define V8_s0(x) _mm256_xor_si256(V8_ROTR(x, 7), _mm256_xor_si256(V8_ROTR(x, 18), _mm256_srli_epi32((x), 3)))
+#define V8_s1(x) _mm256_xor_si256(V8_ROTR(x, 17), _mm256_xor_si256(V8_ROTR(x, 19), _mm256_srli_epi32((x), 10)))
+#define V8_ROUND(a, b, c, d, e, f, g, h, wk) do { \
+    __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, V8_S1(e)), _mm256_add_epi32(V8_CH(e, f, g), (wk))); \
+    __m256i t2 = _mm256_add_epi32(V8_S0(a), V8_MAJ(a, b, c)); \
+    h = g; g = f; f = e; e = _mm256_add_epi32(d, t1); \
+    d = c; c = b; b = a; a = _mm256_add_epi32(t1, t2); \
+} while (0)
+
+__attribute__((target("avx2")))
+static uint32_t sha256_x8_avx2(const uint32_t* midstate, const sha256_precomp_t* first,
+                               const uint32_t* words, size_t blocks,
+                               int difficulty, uint32_t* h0, uint32_t* h1) {
+    __m256i s[8];
+    for (int i = 0; i < 8; i++) {
+        s[i] = _mm256_set1_epi32((int)midstate[i]);
+    }
+
+    for (size_t blk = 0; blk < blocks; blk++) {
+        const uint32_t* bw = words + blk * 16 * 8;
+        __m256i w[16];
+        __m256i a, b, c, d, e, f, g, h;
+
+        if (blk == 0 && first) {
+            // Resume after the precomputed rounds; constant words come from the plan
+            a = _mm256_set1_epi32((int)first->state[0]);
+            b = _mm256_set1_epi32((int)first->state[1]);
+            c = _mm256_set1_epi32((int)first->state[2]);
+            d = _mm256_set1_epi32((int)first->state[3]);
+            e = _mm256_set1_epi32((int)first->state[4]);
+            f = _mm256_set1_epi32((int)first->state[5]);
+            g = _mm256_set1_epi32((int)first->state[6]);
+            h = _mm256_set1_epi32((int)first->state[7]);
+            for (int i = 0; i < 16; i++) {
+                if (first->dep[i]) {
+                    w[i] = _mm256_loadu_si256((const __m256i*)(bw + i * 8));
+                }
+            }
+            for (int i = first->start_round; i < 64; i++) {
+                __m256i wk;
+                if (first->dep[i]) {
+                    if (i >= 16) {
+                        __m256i v = _mm256_set1_epi32((int)first->part[i]);
+                        uint8_t terms = first->terms[i];
+                        if (terms & 1) v = _mm256_add_epi32(v, V8_s1(w[(i - 2) & 15]));
+                        if (terms & 2) v = _mm256_add_epi32(v, w[(i - 7) & 15]);
+                        if (terms & 4) v = _mm256_add_epi32(v, V8_s0(w[(i - 15) & 15]));
+                        if (terms & 8) v = _mm256_add_epi32(v, w[i & 15]);
+                        w[i & 15] = v;
+                    }
+                    wk = _mm256_add_epi32(w[i & 15], _mm256_set1_epi32((int)sha256_k[i]));
+                } else {
+                    wk = _mm256_set1_epi32((int)first->part[i]);
+                }
+                V8_ROUND(a, b, c, d, e, f, g, h, wk);
+            }
+        } else {
+            for (int i = 0; i < 16; i++) {
+                w[i] = _mm256_loadu_si256((const __m256i*)(bw + i * 8));
+            }
+            a = s[0];
+            b = s[1];
+            c = s[2];
+            d = s[3];
+            e = s[4];
+            f = s[5];
+            g = s[6];
+            h = s[7];
+            for (int i = 0; i < 64; i++) {
+                if (i >= 16) {
+                    w[i & 15] = _mm256_add_epi32(_mm256_add_epi32(V8_s1(w[(i - 2) & 15]), w[(i - 7) & 15]),
+                                                 _mm256_add_epi32(V8_s0(w[(i - 15) & 15]), w[i & 15]));
+                }
+                V8_ROUND(a, b, c, d, e, f, g, h, _mm256_add_epi32(_mm256_set1_epi32((int)sha256_k[i]), w[i & 15]));
+            }
+        }
+
+        s[0] = _mm256_add_epi32(s[0], a);
+        s[1] = _mm256_add_epi32(s[1], b);
+
+        // The target only needs the first two words of the final state
+        if (blk + 1 == blocks) {
+            break;
+        }
+        s[2] = _mm256_add_epi32(s[2], c);
+        s[3] = _mm256_add_epi32(s[3], d);
+        s[4] = _mm256_add_epi32(s[4], e);
+        s[5] = _mm256_add_epi32(s[5], f);
+        s[6] = _mm256_add_epi32(s[6], g);
+        s[7] = _mm256_add_epi32(s[7], h);
+    }
+
+    _mm256_storeu_si256((__m256i*)h0, s[0]);
+    _mm256_storeu_si256((__m256i*)h1, s[1]);
+
+    // Check leading zeros across all lanes at once
+    uint32_t m0, m1;
+    sha256_zero_masks(difficulty, &m0, &m1);
+    __m256i zero = _mm256_setzero_si256();
+    __m256i ok = _mm256_and_si256(
+        _mm256_cmpeq_epi32(_mm256_and_si256(s[0], _mm256_set1_epi32((int)m0)), zero),
+        _mm256_cmpeq_epi32(_mm256_and_si256(s[1], _mm256_set1_epi32((int)m1)), zero));
+    return (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(ok));
+}
+
+// AVX-512: 16 lanes, native rotates and ternary logic
+#define V16_ROTR(x, n) _mm512_ror_epi32((x), (n))
+#define V16_CH(x, y, z)  _mm512_ternarylogic_epi32((x), (y), (z), 0xca)
+#define V16_MAJ(x, y, z) _mm512_ternarylogic_epi32((x), (y), (z), 0xe8)
+#define V16_XOR3(x, y, z) _mm512_ternarylogic_epi32((x), (y), (z), 0x96)
+#define V16_S0(x) V16_XOR3(V16_ROTR(x, 2), V16_ROTR(x, 13), V16_ROTR(x, 22))
+#define V16_S1(x) V16_XOR3(V16_ROTR(x, 6), V16_ROTR(x, 11), V16_ROTR(x, 25))
+#define V16_s0(x) V16_XOR3(V16_ROTR(x, 7), V16_ROTR(x, 18), _mm512_srli_epi32((x), 3))
+#define V16_s1(x) V16_XOR3(V16_ROTR(x, 17), V16_ROTR(x, 19), _mm512_srli_epi32((x), 10))
+#define V16_ROUND(a, b, c, d, e, f, g, h, wk) do { \
+    __m512i t1 = _mm512_add_epi32(_mm512_add_epi32(h, V16_S1(e)), _mm512_add_epi32(V16_CH(e, f, g), (wk))); \
+    __m512i t2 = _mm512_add_epi32(V16_S0(a), V16_MAJ(a, b, c)); \
+    h = g; g = f; f = e; e = _mm512_add_epi32(d, t1); \
+    d = c; c = b; b = a; a = _mm512_add_epi32(t1, t2); \
+} while (0)
+
+__attribute__((target("avx512f")))
+static uint32_t sha256_x16_avx512(const uint32_t* midstate, const sha256_precomp_t* first,
+                                  const uint32_t* words, size_t blocks,
+                                  int difficulty, uint32_t* h0, uint32_t* h1) {
+    __m512i s[8];
+    for (int i = 0; i < 8; i++) {
+        s[i] = _mm512_set1_epi32((int)midstate[i]);
+    }
+
+    for (size_t blk = 0; blk < blocks; blk++) {
+        const uint32_t* bw = words + blk * 16 * 16;
+        __m512i w[16];
+        __m512i a, b, c, d, e, f, g, h;
+
+        if (blk == 0 && first) {
+            // Resume after the precomputed rounds; constant words come from the plan
+            a = _mm512_set1_epi32((int)first->state[0]);
+            b = _mm512_set1_epi32((int)first->state[1]);
+            c = _mm512_set1_epi32((int)first->state[2]);
+            d = _mm512_set1_epi32((int)first->state[3]);
+            e = _mm512_set1_epi32((int)first->state[4]);
+            f = _mm512_set1_epi32((int)first->state[5]);
+            g = _mm512_set1_epi32((int)first->state[6]);
+            h = _mm512_set1_epi32((int)first->state[7]);
+            for (int i = 0; i < 16; i++) {
+                if (first->dep[i]) {
+                    w[i] = _mm512_loadu_si512((const void*)(bw + i * 16));
+                }
+            }
+            for (int i = first->start_round; i < 64; i++) {
+                __m512i wk;
+                if (first->dep[i]) {
+                    if (i >= 16) {
+                        __m512i v = _mm512_set1_epi32((int)first->part[i]);
+                        uint8_t terms = first->terms[i];
+                        if (terms & 1) v = _mm512_add_epi32(v, V16_s1(w[(i - 2) & 15]));
+                        if (terms & 2) v = _mm512_add_epi32(v, w[(i - 7) & 15]);
+                        if (terms & 4) v = _mm512_add_epi32(v, V16_s0(w[(i - 15) & 15]));
+                        if (terms & 8) v = _mm512_add_epi32(v, w[i & 15]);
+                        w[i & 15] = v;
+                    }
+                    wk = _mm512_add_epi32(w[i & 15], _mm512_set1_epi32((int)sha256_k[i]));
+                } else {
+                    wk = _mm512_set1_epi32((int)first->part[i]);
+                }
+                V16_ROUND(a, b, c, d, e, f, g, h, wk);
+            }
+        } else {
+            for (int i = 0; i < 16; i++) {
+                w[i] = _mm512_loadu_si512((const void*)(bw + i * 16));
+            }
+            a = s[0];
+            b = s[1];
+            c = s[2];
+            d = s[3];
+            e = s[4];
+            f = s[5];
+            g = s[6];
+            h = s[7];
+            for (int i = 0; i < 64; i++) {
+                if (i >= 16) {
+                    w[i & 15] = _mm512_add_epi32(_mm512_add_epi32(V16_s1(w[(i - 2) & 15]), w[(i - 7) & 15]),
+                                                 _mm512_add_epi32(V16_s0(w[(i - 15) & 15]), w[i & 15]));
+                }
+                V16_ROUND(a, b, c, d, e, f, g, h, _mm512_add_epi32(_mm512_set1_epi32((int)sha256_k[i]), w[i & 15]));
+            }
+        }
+
+        s[0] = _mm512_add_epi32(s[0], a);
+        s[1] = _mm512_add_epi32(s[1], b);
+
+        // The target only needs the first two words of the final state
+        if (blk + 1 == blocks) {
+            break;
+        }
+        s[2] = _mm512_add_epi32(s[2], c);
+        s[3] = _mm512_add_epi32(s[3], d);
+        s[4] = _mm512_add_epi32(s[4], e);
+        s[5] = _mm512_add_epi32(s[5], f);
+        s[6] = _mm512_add_epi32(s[6], g);
+        s[7] = _mm512_add_epi32(s[7], h);
+    }
+
+    _mm512_storeu_si512((void*)h0, s[0]);
+    _mm512_storeu_si512((void*)h1, s[1]);
+
+    // Check leading zeros across all lanes at once
+    uint32_t m0, m1;
+    sha256_zero_masks(difficulty, &m0, &m1);
+    __mmask16 bad = _mm512_test_epi32_mask(s[0], _mm512_set1_epi32((int)m0)) |
+                    _mm512_test_epi32_mask(s[1], _mm512_set1_epi32((int)m1));
+    return (uint32_t)(uint16_t)~bad;
+}
+
+#endif
+
+// Kernel with exactly `lanes` lanes (1, 8 or 16); returns 0 if unsupported
+int sha256_multi_lookup(int lanes, sha256_multi_fn* fn) {
+    *fn = NULL;
+    if (lanes == 1) {
+        return 1;
+    }
+#ifdef SHA256_SIMD_X86
+    __builtin_cpu_init();
+    if (lanes == 16 && __builtin_cpu_supports("avx512f")) {
+        *fn = sha256_x16_avx512;
+        return 16;
+    }
+    if (lanes == 8 && __builtin_cpu_supports("avx2")) {
+        *fn = sha256_x8_avx2;
+        return 8;
+    }
+#endif
+    return 0;
+}
+
+// Fastest kernel for this CPU: AVX-512, then single-lane SHA-NI, then AVX2
+int sha256_multi_select(sha256_multi_fn* fn) {
+    if (sha256_multi_lookup(16, fn)) {
+        return 16;
+    }
+    if (sha256_shani_supported()) {
+        return sha256_multi_lookup(1, fn);
+    }
+    if (sha256_multi_lookup(8, fn)) {
+        return 8;
+    }
+    return sha256_multi_lookup(1, fn);
+}
+
+// Name of the kernel for a lane count
+const char* sha256_multi_name(int lanes) {
+    switch (lanes) {
+        case 16: return "avx512";
+        case 8:  return "avx2";
+        default: return sha256_backend_name();
+    }
+}
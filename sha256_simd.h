@@ -0,0 +1,40 @@
+/*
+ * Multi-buffer SHA256 kernels (AVX2 x8, AVX-512 x16)
+ * Every lane hashes its own message with an identical block layout, which is
+ * exactly what a nonce search produces. Kernels are compiled with per-function
+ * target attributes and picked at runtime, so the binary still runs on CPUs
+ * without AVX2.
+ */
+
+#ifndef SHA256_SIMD_H
+#define SHA256_SIMD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sha256.h"
+
+#define SHA256_MAX_LANES 16
+
+// Compress `blocks` blocks per lane starting from a shared midstate.
+// words holds transposed big-endian message words: words[(block * 16 + i) * lanes + lane].
+// When first is not NULL, block 0 resumes from that plan and only its
+// changing words are read. h0/h1 receive the first two state words per lane;
+// the return value has bit `lane` set when that lane's digest has at least
+// `difficulty` leading zero bits.
+typedef uint32_t (*sha256_multi_fn)(const uint32_t* midstate, const sha256_precomp_t* first,
+                                    const uint32_t* words, size_t blocks,
+                                    int difficulty, uint32_t* h0, uint32_t* h1);
+
+// Fastest kernel for this CPU: AVX-512, then single-lane SHA-NI, then AVX2.
+// Returns the lane count and stores the kernel in *fn (NULL for the
+// single-lane sha256_transform path).
+int sha256_multi_select(sha256_multi_fn* fn);
+
+// Kernel with exactly `lanes` lanes (1, 8 or 16); returns 0 if unsupported
+int sha256_multi_lookup(int lanes, sha256_multi_fn* fn);
+
+// Name of the kernel for a lane count ("scalar", "shani", "avx2", "avx512")
+const char* sha256_multi_name(int lanes);
+
+#endif
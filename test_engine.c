@@ -0,0 +1,190 @@
+/*
+ * Engine regression checks: nonce slots at the edge of their width
+ * Lanes step past the last nonce of a range, so a range ending just below
+ * a power of ten must not carry out of the counter digits. Mined events
+ * must also commit to their target difficulty in the nonce tag.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nip13_engine.h"
+#include "nostr_event.h"
+
+static const char* test_event =
+    "{\"id\":\"\",\"pubkey\":\"32e1827635450ebb3c5a7d12c1f8e7b2b514439ac10a67eef3d9fd9c5c68e245\","
+    "\"created_at\":1673347337,\"kind\":1,\"tags\":[[\"t\",\"pow\"]],\"content\":\"slot edge\",\"sig\":\"\"}";
+
+// Same event carrying a nonce tag from an earlier, easier search
+static const char* retarget_event =
+    "{\"id\":\"\",\"pubkey\":\"32e1827635450ebb3c5a7d12c1f8e7b2b514439ac10a67eef3d9fd9c5c68e245\","
+    "\"created_at\":1673347337,\"kind\":1,\"tags\":[[\"nonce\",\"776\",\"4\"],[\"t\",\"pow\"]],"
+    "\"content\":\"slot edge\",\"sig\":\"\"}";
+
+#define TEST_TARGET 12
+
+// Every lane must hash exactly the event its nonce stands for
+static int check_lanes(const nip13_template_t* tmpl, nip13_batch_t* batch, uint64_t end_nonce) {
+    for (int lane = 0; lane < batch->lanes; lane++) {
+        uint64_t nonce = batch->cursors[lane].nonce;
+        if (nonce >= end_nonce) {
+            continue;
+        }
+        uint8_t hashed[SHA256_DIGEST_SIZE];
+        uint8_t expected[SHA256_DIGEST_SIZE];
+        nip13_cursor_hash(&batch->cursors[lane], hashed);
+        char* event = nip13_template_event_json(tmpl, test_event, nonce);
+        if (!event) {
+            return 0;
+        }
+        calculate_nostr_event_id(event, expected);
+        free(event);
+        if (memcmp(hashed, expected, SHA256_DIGEST_SIZE) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Mine the last nonces of [0, end_nonce) the way a pool chunk does, from
+// every alignment of the final scan, then come back for an earlier chunk
+// and check what its lanes hash
+static int check_range_end(uint64_t end_nonce, int lanes) {
+    nip13_template_t tmpl;
+    nip13_batch_t batch;
+    if (!nip13_template_init(&tmpl, test_event, end_nonce, TEST_TARGET)) {
+        return 0;
+    }
+    if (!nip13_batch_init(&batch, &tmpl, lanes)) {
+        nip13_template_free(&tmpl);
+        return -1;
+    }
+
+    int ok = 1;
+    for (int offset = 0; ok && offset < batch.lanes; offset++) {
+        uint64_t tail_start = end_nonce > 2u * batch.lanes + offset ? end_nonce - 2u * batch.lanes - offset : 0;
+        nip13_batch_seek(&batch, tail_start);
+        while (nip13_batch_nonce(&batch) < end_nonce) {
+            uint32_t hits;
+            nip13_batch_scan(&batch, 64, end_nonce, &hits);
+            nip13_batch_next(&batch);
+        }
+
+        uint64_t earlier = tail_start > 1000 ? tail_start - 1000 : 0;
+        nip13_batch_seek(&batch, earlier);
+        ok = check_lanes(&tmpl, &batch, end_nonce);
+        nip13_batch_seek(&batch, tail_start);
+        ok = ok && check_lanes(&tmpl, &batch, end_nonce);
+    }
+
+    nip13_batch_free(&batch);
+    nip13_template_free(&tmpl);
+    return ok;
+}
+
+// Mine the event to TEST_TARGET bits: the proof's event must commit to the
+// target as the nonce tag's third element (NIP-13) and hash to the proof
+static int check_target(const char* event_json) {
+    nip13_template_t tmpl;
+    nip13_batch_t batch;
+    if (!nip13_template_init(&tmpl, event_json, 1000000000ULL, TEST_TARGET)) {
+        return 0;
+    }
+    if (!nip13_batch_init(&batch, &tmpl, 0)) {
+        nip13_template_free(&tmpl);
+        return 0;
+    }
+
+    int ok = 0;
+    for (;;) {
+        uint32_t hits;
+        nip13_batch_scan(&batch, TEST_TARGET, 1000000000ULL, &hits);
+        if (hits) {
+            int lane = __builtin_ctz(hits);
+            uint8_t hashed[SHA256_DIGEST_SIZE];
+            uint8_t expected[SHA256_DIGEST_SIZE];
+            nip13_cursor_hash(&batch.cursors[lane], hashed);
+
+            char* event = nip13_template_event_json(&tmpl, event_json, nip13_batch_nonce(&batch) + lane);
+            nostr_event_t ev;
+            if (event && nostr_event_parse(event, &ev)) {
+                char target_element[32];
+                snprintf(target_element, sizeof(target_element), "\",\"%d\"]", TEST_TARGET);
+                if (ev.nonce_tag >= 0) {
+                    const nostr_tag_t* tag = &ev.tag[ev.nonce_tag];
+                    const char* value_end = event + tag->value.offset + tag->value.length - 1;
+                    size_t rest = tag->whole.offset + tag->whole.length - (value_end - event);
+                    ok = rest == strlen(target_element) && memcmp(value_end, target_element, rest) == 0;
+                }
+                nostr_event_free(&ev);
+                calculate_nostr_event_id(event, expected);
+                ok = ok && memcmp(hashed, expected, SHA256_DIGEST_SIZE) == 0 &&
+                     count_leading_zeros(hashed) >= TEST_TARGET;
+            }
+            free(event);
+            break;
+        }
+        nip13_batch_next(&batch);
+    }
+
+    nip13_batch_free(&batch);
+    nip13_template_free(&tmpl);
+    return ok;
+}
+
+int main(void) {
+    static const int lane_counts[] = { 1, 8, 16 };
+    // Just below 10^k, including the gaps the lanes' overshoot crosses
+    static const uint64_t below[] = { 1, 2, SHA256_MAX_LANES, SHA256_MAX_LANES + 1, SHA256_MAX_LANES + 8,
+                                      2 * SHA256_MAX_LANES - 2, 2 * SHA256_MAX_LANES - 1 };
+    int failures = 0;
+    int checks = 0;
+
+    for (size_t l = 0; l < sizeof(lane_counts) / sizeof(lane_counts[0]); l++) {
+        for (uint64_t power = 100; power <= 10000000000000000000ULL / 10; power *= 10) {
+            for (size_t b = 0; b < sizeof(below) / sizeof(below[0]); b++) {
+                if (below[b] >= power) {
+                    continue;
+                }
+                uint64_t end_nonce = power - below[b];
+                int result = check_range_end(end_nonce, lane_counts[l]);
+                if (result < 0) {
+                    break;          // No kernel with this many lanes on this CPU
+                }
+                checks++;
+                if (!result) {
+                    printf("❌ %d lanes, end_nonce %llu: lanes hash a different nonce than they report\n",
+                           lane_counts[l], (unsigned long long)end_nonce);
+                    failures++;
+                }
+            }
+        }
+    }
+
+    // A range ending at the top of uint64_t must still get a slot
+    nip13_layout_t layout;
+    checks++;
+    if (!nip13_plan_layout(test_event, ~0ULL, TEST_TARGET, &layout) || layout.counter_width != NIP13_NONCE_MAX_WIDTH) {
+        printf("❌ end_nonce 2^64 - 1: no %d-digit slot\n", NIP13_NONCE_MAX_WIDTH);
+        failures++;
+    }
+
+    // Mined events commit to their target, replacing an older one
+    const char* const target_events[] = { test_event, retarget_event };
+    for (size_t e = 0; e < sizeof(target_events) / sizeof(target_events[0]); e++) {
+        checks++;
+        if (!check_target(target_events[e])) {
+            printf("❌ %s event: mined nonce tag does not commit to target %d\n",
+                   e == 0 ? "untagged" : "retargeted", TEST_TARGET);
+            failures++;
+        }
+    }
+
+    if (failures) {
+        printf("💔 %d of %d engine checks failed\n", failures, checks);
+        return 1;
+    }
+    printf("✅ %d engine checks passed\n", checks);
+    return 0;
+}
@@ -0,0 +1,144 @@
+/*
+ * Library regression checks: job parameters nip13_job_create must reject,
+ * and the order of on_done against nip13_job_wait
+ * Tiers are reported as first reached and end the search at the last one,
+ * so the last tier has to be the difficulty itself.
+ */
+
+// nanosleep under -std=c11
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#include "nip13_pool.h"
+
+static const char* test_event =
+    "{\"id\":\"\",\"pubkey\":\"32e1827635450ebb3c5a7d12c1f8e7b2b514439ac10a67eef3d9fd9c5c68e245\","
+    "\"created_at\":1673347337,\"kind\":1,\"tags\":[[\"t\",\"pow\"]],\"content\":\"tiers\",\"sig\":\"\"}";
+
+// Tier list and difficulty of one case; accepted tells whether a job may be created
+typedef struct {
+    const char* name;
+    int tiers[NIP13_MAX_TIERS];
+    int tier_count;
+    int difficulty;
+    int accepted;
+} tier_case_t;
+
+// Create (and for accepted cases, mine) one job; returns 1 when it behaved
+static int check_tiers(nip13_pool_t* pool, const tier_case_t* tc) {
+    nip13_job_params_t params = { .difficulty = tc->difficulty, .end_nonce = 100000000ULL,
+                                  .tiers = tc->tiers, .tier_count = tc->tier_count };
+    nip13_job_t* job = nip13_job_create(pool, test_event, &params);
+    if (!tc->accepted) {
+        if (job) {
+            nip13_job_free(job);
+        }
+        return job == NULL;
+    }
+    if (!job) {
+        return 0;
+    }
+
+    // FOUND only once the difficulty itself is reached, with every tier on the way
+    nip13_job_start(job);
+    nip13_status_t status = nip13_job_wait(job);
+    nip13_proof_t proof;
+    int ok = status == NIP13_JOB_FOUND && nip13_job_result(job, &proof) && proof.zeros >= tc->difficulty;
+    for (int tier = 0; ok && tier < tc->tier_count; tier++) {
+        ok = nip13_job_tier(job, tier, &proof) && proof.zeros >= tc->tiers[tier];
+    }
+    nip13_job_free(job);
+    return ok;
+}
+
+// Slow on_done: a waiter must not see the job retired before it returns
+static void slow_done(nip13_job_t* job, void* user) {
+    (void)job;
+    struct timespec pause = { 0, 50 * 1000 * 1000 };
+    nanosleep(&pause, NULL);
+    atomic_store((atomic_int*)user, 1);
+}
+
+// on_done that frees its own job, as the daemon does
+static void free_done(nip13_job_t* job, void* user) {
+    nip13_job_free(job);
+    atomic_fetch_add((atomic_int*)user, 1);
+}
+
+static int check_on_done(nip13_pool_t* pool) {
+    atomic_int done = 0;
+    nip13_job_params_t params = { .difficulty = 8, .end_nonce = 100000000ULL, .on_done = slow_done, .user = &done };
+    nip13_job_t* job = nip13_job_create(pool, test_event, &params);
+    if (!job) {
+        return 0;
+    }
+    nip13_job_start(job);
+    int ok = nip13_job_wait(job) == NIP13_JOB_FOUND && atomic_load(&done);
+    nip13_job_free(job);
+    if (!ok) {
+        return 0;
+    }
+
+    // Jobs freed by their own on_done; the pool releases them afterwards
+    atomic_int freed = 0;
+    params.on_done = free_done;
+    params.user = &freed;
+    for (int i = 0; i < 16; i++) {
+        job = nip13_job_create(pool, test_event, &params);
+        if (!job) {
+            return 0;
+        }
+        nip13_job_start(job);
+    }
+    while (atomic_load(&freed) < 16) {
+        struct timespec pause = { 0, 1000 * 1000 };
+        nanosleep(&pause, NULL);
+    }
+    return 1;
+}
+
+int main(void) {
+    static const tier_case_t cases[] = {
+        { "tiers ending at the difficulty", { 6, 10 }, 2, 10, 1 },
+        { "single tier at the difficulty", { 8 }, 1, 8, 1 },
+        { "last tier below the difficulty", { 6, 8 }, 2, 12, 0 },
+        { "last tier above the difficulty", { 6, 14 }, 2, 10, 0 },
+        { "tiers out of order", { 10, 6 }, 2, 6, 0 },
+        { "tier of 0 bits", { 0, 8 }, 2, 8, 0 },
+    };
+    int failures = 0;
+    int checks = 0;
+
+    nip13_pool_t* pool = nip13_pool_create(2, NULL);
+    if (!pool) {
+        printf("❌ Cannot start the worker pool\n");
+        return 1;
+    }
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        checks++;
+        if (!check_tiers(pool, &cases[i])) {
+            printf("❌ %s: job was %s\n", cases[i].name,
+                   cases[i].accepted ? "rejected or did not reach every tier" : "accepted");
+            failures++;
+        }
+    }
+
+    checks++;
+    if (!check_on_done(pool)) {
+        printf("❌ on_done: nip13_job_wait returned before on_done finished\n");
+        failures++;
+    }
+    nip13_pool_destroy(pool);
+
+    if (failures) {
+        printf("💔 %d of %d library checks failed\n", failures, checks);
+        return 1;
+    }
+    printf("✅ %d library checks passed\n", checks);
+    return 0;
+}
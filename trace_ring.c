@@ -0,0 +1,91 @@
+/*
+ * Per-thread event rings for timeline traces of the worker pool
+ * Exported in the Chrome trace-event format read by chrome://tracing,
+ * Perfetto and speedscope
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace_ring.h"
+
+int trace_ring_init(trace_ring_t* ring, uint64_t capacity) {
+    uint64_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    ring->events = calloc(size, sizeof(trace_event_t));
+    ring->mask = size - 1;
+    ring->next = 0;
+    return ring->events != NULL;
+}
+
+void trace_ring_free(trace_ring_t* ring) {
+    free(ring->events);
+    ring->events = NULL;
+    ring->next = 0;
+}
+
+// Microseconds after the origin, the unit of Chrome trace timestamps
+static unsigned long long trace_ts(uint64_t ts_us, uint64_t origin_us) {
+    return ts_us >= origin_us ? (unsigned long long)(ts_us - origin_us) : 0;
+}
+
+int trace_ring_write_chrome(FILE* out, const trace_ring_t* rings, int count, uint64_t origin_us) {
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"nip13 pool\"}}");
+
+    for (int tid = 0; tid < count; tid++) {
+        const trace_ring_t* ring = &rings[tid];
+        fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"worker %d\"}}",
+                tid, tid);
+        if (!ring->events) {
+            continue;
+        }
+
+        // Oldest surviving event first; a job whose start was overwritten
+        // loses its end too, so every span still opens before it closes
+        uint64_t first = ring->next > ring->mask + 1 ? ring->next - (ring->mask + 1) : 0;
+        int open = 0;
+        for (uint64_t i = first; i < ring->next; i++) {
+            const trace_event_t* event = &ring->events[i & ring->mask];
+            unsigned long long ts = trace_ts(event->ts_us, origin_us);
+            switch ((trace_type_t)event->type) {
+            case TRACE_JOB_START:
+                fprintf(out, ",\n{\"name\":\"job %u\",\"cat\":\"job\",\"ph\":\"B\",\"ts\":%llu,\"pid\":1,\"tid\":%d}",
+                        event->job, ts, tid);
+                open = 1;
+                break;
+            case TRACE_CHUNK:
+                if (!open) {
+                    break;
+                }
+                fprintf(out, ",\n{\"name\":\"chunk\",\"cat\":\"chunk\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%u,\"pid\":1,"
+                        "\"tid\":%d,\"args\":{\"job\":%u,\"first_nonce\":%llu,\"nonces\":%u}}",
+                        ts, event->dur_us, tid, event->job, (unsigned long long)event->nonce, event->count);
+                break;
+            case TRACE_SOLUTION:
+                fprintf(out, ",\n{\"name\":\"solution\",\"cat\":\"job\",\"ph\":\"i\",\"s\":\"p\",\"ts\":%llu,\"pid\":1,"
+                        "\"tid\":%d,\"args\":{\"job\":%u,\"nonce\":%llu}}",
+                        ts, tid, event->job, (unsigned long long)event->nonce);
+                break;
+            case TRACE_STOP:
+                fprintf(out, ",\n{\"name\":\"stop observed\",\"cat\":\"job\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%llu,"
+                        "\"pid\":1,\"tid\":%d,\"args\":{\"job\":%u}}",
+                        ts, tid, event->job);
+                break;
+            case TRACE_JOB_EXIT:
+                if (!open) {
+                    break;
+                }
+                fprintf(out, ",\n{\"name\":\"job %u\",\"cat\":\"job\",\"ph\":\"E\",\"ts\":%llu,\"pid\":1,\"tid\":%d}",
+                        event->job, ts, tid);
+                open = 0;
+                break;
+            }
+        }
+    }
+
+    fprintf(out, "\n]}\n");
+    return !ferror(out);
+}
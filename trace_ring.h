@@ -0,0 +1,58 @@
+/*
+ * Per-thread event rings for timeline traces of the worker pool
+ * Each worker records into its own ring, so recording takes no lock and no
+ * atomic; the rings are exported as Chrome trace-event JSON once the
+ * workers are idle.
+ */
+
+#ifndef TRACE_RING_H
+#define TRACE_RING_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+typedef enum {
+    TRACE_JOB_START,                // Worker picked up a job
+    TRACE_CHUNK,                    // Chunk claimed at ts and finished dur_us later
+    TRACE_SOLUTION,                 // Worker published the proof
+    TRACE_STOP,                     // Worker saw the job stopped by another thread, a cancel or the deadline
+    TRACE_JOB_EXIT,                 // Worker left the job
+} trace_type_t;
+
+typedef struct {
+    uint64_t ts_us;                 // nip13_time_us() clock
+    uint64_t nonce;                 // Chunk: first nonce; solution: winning nonce
+    uint32_t job;                   // Pool-wide job number
+    uint32_t dur_us;                // Chunk duration
+    uint32_t count;                 // Chunk: nonces claimed
+    uint32_t type;                  // trace_type_t
+} trace_event_t;
+
+// Ring of the most recent events of one thread
+typedef struct {
+    trace_event_t* events;
+    uint64_t mask;                  // Capacity - 1 (capacity is a power of two)
+    uint64_t next;                  // Events recorded so far, including overwritten ones
+} trace_ring_t;
+
+// Capacity is rounded up to a power of two; returns 0 when out of memory
+int trace_ring_init(trace_ring_t* ring, uint64_t capacity);
+void trace_ring_free(trace_ring_t* ring);
+
+// Keep the event, overwriting the oldest once the ring is full
+static inline void trace_ring_record(trace_ring_t* ring, trace_type_t type, uint32_t job, uint64_t ts_us,
+                                     uint32_t dur_us, uint64_t nonce, uint32_t count) {
+    trace_event_t* event = &ring->events[ring->next++ & ring->mask];
+    event->ts_us = ts_us;
+    event->nonce = nonce;
+    event->job = job;
+    event->dur_us = dur_us;
+    event->count = count;
+    event->type = type;
+}
+
+// Write the rings (one trace thread per ring) as a Chrome trace-event JSON
+// object, timestamps relative to origin_us. Returns 0 on a write error.
+int trace_ring_write_chrome(FILE* out, const trace_ring_t* rings, int count, uint64_t origin_us);
+
+#endif